@@ -0,0 +1,112 @@
+/**
+ * Copyright 2017, 2019 Dipl.-Inform. Kai Hofmann
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <LTC6802Stack.h>
+#include <LTC6802SPITransport.h>
+#include <LTC6802Acquisition.h>
+#include <SPI.h>
+
+
+/**
+ * Number of LTC6802-2 chips on the bus.
+ */
+static const byte numChips = 4;
+
+/**
+ * Address of the first chip, the others follow consecutively.
+ */
+static const byte firstAddress = 0x80;
+
+/**
+ * Chip select pin.
+ */
+static const byte csPin = 10;
+
+/**
+ * Interrupt pin, wired to SDO (MISO) of the chips.
+ */
+static const byte sdoPin = 2;
+
+/**
+ * Stack of all chips, 12 cells each.
+ */
+static LTC6802Stack<numChips> stack(LTC6802SPITransport::standard(), csPin, firstAddress);
+
+/**
+ * Snapshot buffers.
+ */
+static byte buffer[LTC6802Snapshot::bufferSize(numChips)];
+
+/**
+ * Latest complete scan, published by the interrupt.
+ */
+static LTC6802Snapshot snapshot(numChips, buffer);
+
+/**
+ * Interrupt driven acquisition.
+ */
+static LTC6802Acquisition acquisition(stack, snapshot);
+
+
+/**
+ * SDO rising edge: conversion done.
+ */
+static void onSdo()
+ {
+  acquisition.onEdge();
+ }
+
+
+/**
+ * Arduino setup.
+ */
+void setup()
+ {
+  Serial.begin(115200);
+  LTC6802::initSPI();  // Init SPI bus
+  stack.cfgRead();     // Read configuration from chips
+  for (byte chip = 0; chip < numChips; ++chip)
+   {
+    stack.cfg(chip)[0] = (stack.cfg(chip)[0] & 0xf8) | 1; // Measure mode 13ms
+   }
+  stack.cfgWrite();    // Write configuration back to chips
+  pinMode(sdoPin, INPUT_PULLUP);
+  SPI.usingInterrupt(digitalPinToInterrupt(sdoPin)); // Keep the interrupt out of other SPI transactions
+  attachInterrupt(digitalPinToInterrupt(sdoPin), onSdo, RISING);
+  acquisition.begin(); // Level polling on, first conversion started
+ }
+
+
+/**
+ * Arduino main loop.
+ */
+void loop()
+ {
+  acquisition.check(); // Restart if an edge got lost
+  if (!snapshot.update())
+   {
+    return;            // Free for other work until the next scan is complete
+   }
+  const LTC6802Snapshot::View &scan = snapshot.get(); // Unchanged until the next update(), no copy
+  uint16_t millivolts[numChips * LTC6802::maxCells];
+  scan.cellsGetMillivolts(millivolts);
+  Serial.print(scan.getSequence());
+  for (unsigned int cell = 0; cell < numChips * LTC6802::maxCells; ++cell)
+   {
+    Serial.print(" ");
+    Serial.print(millivolts[cell]);
+   }
+  Serial.println();
+ }
@@ -0,0 +1,97 @@
+/**
+ * Copyright 2017, 2019 Dipl.-Inform. Kai Hofmann
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <LTC6802Stack.h>
+#include <LTC6802SPITransport.h>
+#include <LTC6802Thermistor.h>
+#include <LTC6802Profile.h>
+#include <LTC6802ScanPipeline.h>
+
+
+/**
+ * Number of LTC6802-2 chips on the bus.
+ */
+static const byte numChips = 4;
+
+/**
+ * Address of the first chip, the others follow consecutively.
+ */
+static const byte firstAddress = 0x80;
+
+/**
+ * Chip select pin.
+ */
+static const byte csPin = 10;
+
+/**
+ * Stack of all chips, 12 cells each.
+ */
+static LTC6802Stack<numChips> stack(LTC6802SPITransport::standard(), csPin, firstAddress);
+
+/**
+ * Scan with cell and temperature conversions overlapping the reads.
+ */
+static LTC6802ScanPipeline pipeline(stack);
+
+
+/**
+ * Arduino setup.
+ */
+void setup()
+ {
+  Serial.begin(9600);
+  LTC6802::initSPI();  // Init SPI bus
+  stack.cfgRead();     // Read configuration from chips
+  for (byte chip = 0; chip < numChips; ++chip)
+   {
+    stack.cfg(chip)[0] = (stack.cfg(chip)[0] & 0xf8) | 1; // Measure mode 13ms
+   }
+  stack.cfgWrite();    // Write configuration back to chips
+  pipeline.begin();    // Start the first conversion
+  Serial.println("Initialized stack");
+  delay(1000);
+ }
+
+
+/**
+ * Arduino main loop.
+ */
+void loop()
+ {
+  stack.keepAlive();          // Rewrite configuration only if chips lost it, and keep the 2.5s watchdog from resetting them
+  pipeline.scan();            // Convert cells and temperatures on all chips at once, reading each group while the other converts
+  for (byte chip = 0; chip < numChips; ++chip)
+   {
+    Serial.print(chip);
+    Serial.print(": ");
+    const byte *const cv = stack.cells(chip);
+    for (byte reg = 0; reg < LTC6802::cellRegisters; ++reg)
+     {
+      Serial.print(cv[reg], HEX);
+      Serial.print(" ");
+     }
+    LTC6802::Temperatures temperatures;
+    LTC6802::temperaturesDecode(stack.temperatures(chip), temperatures);
+    Serial.print(" die: ");
+    Serial.print(temperatures.internal);      // 0.1 degree celsius
+    Serial.print(" ntc1: ");
+    Serial.print(LTC6802Thermistor<10000, 3380, 10000>::deciCelsius(temperatures.etmp1)); // 10k NTC with 10k pull up to VREF
+    Serial.println();
+   }
+  #ifdef LTC6802_PROFILE
+    LTC6802Profile::debugOutput(); // Driver timings in us when the library is built with LTC6802_PROFILE
+  #endif
+  delay(3000);
+ }
@@ -0,0 +1,80 @@
+/**
+ * Copyright 2017, 2019 Dipl.-Inform. Kai Hofmann
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <LTC6802Stack.h>
+#include <LTC6802SPITransport.h>
+#include <LTC6802Telemetry.h>
+
+
+/**
+ * Number of LTC6802-2 chips on the bus.
+ */
+static const byte numChips = 4;
+
+/**
+ * Address of the first chip, the others follow consecutively.
+ */
+static const byte firstAddress = 0x80;
+
+/**
+ * Chip select pin.
+ */
+static const byte csPin = 10;
+
+/**
+ * Stack of all chips, 12 cells each.
+ */
+static LTC6802Stack<numChips> stack(LTC6802SPITransport::standard(), csPin, firstAddress);
+
+/**
+ * Binary telemetry encoder, decode on the host with extras/telemetry.
+ */
+static LTC6802Telemetry telemetry;
+
+
+/**
+ * Arduino setup.
+ */
+void setup()
+ {
+  Serial.begin(115200);
+  LTC6802::initSPI();  // Init SPI bus
+  stack.cfgRead();     // Read configuration from chips
+  for (byte chip = 0; chip < numChips; ++chip)
+   {
+    stack.cfg(chip)[0] = (stack.cfg(chip)[0] & 0xf8) | 1; // Measure mode 13ms
+   }
+  stack.cfgWrite();    // Write configuration back to chips
+ }
+
+
+/**
+ * Arduino main loop.
+ */
+void loop()
+ {
+  stack.keepAlive();          // Rewrite configuration only if chips lost it, and keep the 2.5s watchdog from resetting them
+  stack.temperatureMeasure(); // Start temperature conversion on all chips at once
+  stack.temperatureRead();    // Read temperatures from all chips
+  stack.cellsMeasure();       // Start cell voltage conversion on all chips at once
+  stack.cellsRead();          // Read cell voltages from all chips
+  stack.flagsRead();          // Read comparator flags from all chips
+  for (byte chip = 0; chip < numChips; ++chip)
+   {
+    // Raw registers are smallest, the host decodes them
+    telemetry.encode(stack, chip, LTC6802Telemetry::cellsGroup | LTC6802Telemetry::temperaturesGroup | LTC6802Telemetry::flagsGroup);
+    Serial.write(telemetry.getFrame(), telemetry.getLength());
+   }
+ }
@@ -0,0 +1,196 @@
+/**
+ * Copyright 2017, 2019 Dipl.-Inform. Kai Hofmann
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Cell voltage decode micro benchmark.
+//
+// Build and run on the host:
+//
+//   g++ -std=c++17 -O2 -I../../src -I../host ../../src/*.cpp ../host/*.cpp decodeBenchmark.cpp -o decodeBenchmark
+//   ./decodeBenchmark [chips] [iterations]
+//
+// Compares the floating point unpacking of cellsDebugOutput() with the
+// integer decode of LTC6802::cellsDecode() and the stack wide variant.
+// Every variant sums all decoded values so none of the work can be
+// optimized away, and reports the best of several runs after a warm up
+// run, single runs are noisy on a loaded host.
+#include <LTC6802.h>
+#include <LTC6802Stack.h>
+#include <LTC6802Simulator.h>
+#include <LTC6802HostTransport.h>
+#include <chrono>
+#include <math.h>
+#include <stdlib.h>
+#include <vector>
+
+
+/**
+ * Optimization barrier for results.
+ */
+static volatile double sink;
+
+
+/**
+ * Unpack and scale like cellsDebugOutput() does.
+ *
+ * @param CV 18 cell voltage registers
+ * @param volts Array for 12 voltages
+ */
+static void legacyDecode(const byte *const CV, double *const volts)
+ {
+  word cellvolts[LTC6802::maxCells];
+  for (int pair = 0; pair < LTC6802::maxCells / 2; ++pair)
+   {
+    cellvolts[2 * pair] = CV[3 * pair] | ((CV[3 * pair + 1] & 0x0F) << 8);
+    cellvolts[2 * pair + 1] = ((CV[3 * pair + 1] & 0xf0) >> 4) | (CV[3 * pair + 2] << 4);
+   }
+  for (int i = 0; i < LTC6802::maxCells; ++i)
+   {
+    volts[i] = cellvolts[i] * 1.5 / 1000;
+   }
+ }
+
+
+/**
+ * Timed runs per variant, the first one warms up.
+ */
+static const int runs = 6;
+
+
+/**
+ * Time a decode function.
+ *
+ * @param name Variant name
+ * @param chipsPerCall Chips decoded per call
+ * @param iterations Number of calls per run
+ * @param decode Decode function
+ */
+template <typename Decode> static void measure(const char *const name, const int chipsPerCall, const int iterations, Decode decode)
+ {
+  double best = 0.0;
+  for (int run = 0; run < runs; ++run)
+   {
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i)
+     {
+      decode();
+     }
+    const auto end = std::chrono::steady_clock::now();
+    const double nanos = std::chrono::duration<double, std::nano>(end - start).count();
+    if ((run == 1) || ((run > 1) && (nanos < best)))
+     {
+      best = nanos;
+     }
+   }
+  printf("%-32s %10.2f ns/chip\n", name, best / iterations / chipsPerCall);
+ }
+
+
+int main(const int argc, const char *const argv[])
+ {
+  const int numChips = (argc > 1) ? atoi(argv[1]) : 16;
+  const int iterations = (argc > 2) ? atoi(argv[2]) : 200000;
+
+  std::vector<LTC6802Simulator> sims;
+  sims.reserve(numChips);
+  std::vector<LTC6802Simulator *> simPtrs;
+  srand(1);
+  for (int i = 0; i < numChips; ++i)
+   {
+    sims.emplace_back((byte)(0x80 + i));
+    for (byte cell = 0; cell < LTC6802::maxCells; ++cell)
+     {
+      sims.back().setCellCode(cell, rand() & 0x0fff);
+     }
+    simPtrs.push_back(&sims.back());
+   }
+  LTC6802HostTransport chain(simPtrs.data(), numChips, LTC6802HostTransport::daisyChain);
+  std::vector<byte> buffer(LTC6802StackBase::bufferSize(numChips));
+  LTC6802StackBase stack(chain, 10, numChips, buffer.data());
+  stack.cellsMeasure();
+  stack.cellsRead();
+
+  // Cross check integer decode against the floating point reference
+  std::vector<uint16_t> millivolts(numChips * LTC6802::maxCells);
+  stack.cellsGetMillivolts(millivolts.data());
+  for (int chip = 0; chip < numChips; ++chip)
+   {
+    double volts[LTC6802::maxCells];
+    legacyDecode(stack.cells(chip), volts);
+    for (int i = 0; i < LTC6802::maxCells; ++i)
+     {
+      if (fabs(volts[i] * 1000 - millivolts[chip * LTC6802::maxCells + i]) > 0.5001)
+       {
+        printf("mismatch chip %d cell %d: %f V vs %u mV\n", chip, i, volts[i], millivolts[chip * LTC6802::maxCells + i]);
+        return 1;
+       }
+     }
+   }
+
+  printf("%d chips, %d iterations\n", numChips, iterations);
+  measure("legacy unpack, double volts", numChips, iterations / numChips, [&]()
+   {
+    double volts[LTC6802::maxCells];
+    double sum = 0.0;
+    for (int chip = 0; chip < numChips; ++chip)
+     {
+      legacyDecode(stack.cells(chip), volts);
+      for (int i = 0; i < LTC6802::maxCells; ++i)
+       {
+        sum += volts[i];
+       }
+     }
+    sink = sum;
+   });
+  measure("cellsDecode per chip, codes", numChips, iterations / numChips, [&]()
+   {
+    uint16_t cells[LTC6802::maxCells];
+    unsigned long sum = 0;
+    for (int chip = 0; chip < numChips; ++chip)
+     {
+      LTC6802::cellsDecode(stack.cells(chip), cells, false);
+      for (int i = 0; i < LTC6802::maxCells; ++i)
+       {
+        sum += cells[i];
+       }
+     }
+    sink = sum;
+   });
+  measure("cellsDecode per chip, mV", numChips, iterations / numChips, [&]()
+   {
+    uint16_t cells[LTC6802::maxCells];
+    unsigned long sum = 0;
+    for (int chip = 0; chip < numChips; ++chip)
+     {
+      LTC6802::cellsDecode(stack.cells(chip), cells, true);
+      for (int i = 0; i < LTC6802::maxCells; ++i)
+       {
+        sum += cells[i];
+       }
+     }
+    sink = sum;
+   });
+  measure("stack cellsGetMillivolts", numChips, iterations / numChips, [&]()
+   {
+    stack.cellsGetMillivolts(millivolts.data());
+    unsigned long sum = 0;
+    for (const uint16_t value : millivolts)
+     {
+      sum += value;
+     }
+    sink = sum;
+   });
+  return 0;
+ }
@@ -0,0 +1,389 @@
+/**
+ * Copyright 2017, 2019 Dipl.-Inform. Kai Hofmann
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Scan queue benchmark for the Linux gateway.
+//
+// Build and run on the host:
+//
+//   g++ -std=c++17 -O2 -pthread -I../../src -I../host -I../gateway ../../src/*.cpp ../host/*.cpp ../gateway/*.cpp queueBenchmark.cpp -o queueBenchmark
+//   ./queueBenchmark [chips] [scans] [capacity]
+//
+// An acquisition thread pushes stack scans, a processing thread pops them.
+// Compares LTC6802ScanQueue with a preallocated ring behind a mutex: scans
+// per second delivered without loss, and push latency and drops with a
+// fast and a slow consumer, where the acquisition must never block. Checks
+// that a consumer holding a record while the producer overruns the queue
+// gets the newest scans. Finally feeds the queue from the simulated
+// pipelined scan loop. Run it on a
+// multi core machine, on a single core the threads only take turns.
+#include <LTC6802.h>
+#include <LTC6802Stack.h>
+#include <LTC6802ScanPipeline.h>
+#include <LTC6802ScanQueue.h>
+#include <LTC6802Simulator.h>
+#include <LTC6802HostTransport.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+
+/**
+ * Reference queue: the same preallocated records behind a mutex.
+ *
+ * Scans are decoded outside the lock and copied in and out under it, so
+ * the lock is held as briefly as a mutex queue allows.
+ */
+class MutexQueue
+ {
+  public:
+    /**
+     * Constructor.
+     *
+     * @param numChips Number of chips of the stack
+     * @param capacity Scans the queue holds
+     * @param overflow Overflow policy
+     */
+    MutexQueue(const byte numChips, const size_t capacity, const LTC6802ScanQueue::Overflow overflow)
+     : numChips(numChips), capacity(capacity), overflow(overflow), records(capacity + 2)
+     {
+      for (LTC6802ScanQueue::Record &record : records)
+       {
+        record.registers.assign((size_t)numChips * LTC6802ScanQueue::chipBytes, 0);
+        record.millivolts.assign((size_t)numChips * LTC6802::maxCells, 0);
+        record.temperatures.assign(numChips, LTC6802::Temperatures());
+       }
+     }
+
+    /**
+     * Queue a scan, see LTC6802ScanQueue::push().
+     */
+    bool push(const LTC6802StackBase &stack)
+     {
+      LTC6802ScanQueue::Record &staging = records[capacity];
+      for (byte chip = 0; chip < numChips; ++chip)
+       {
+        byte *dst = &staging.registers[chip * LTC6802ScanQueue::chipBytes];
+        memcpy(dst, stack.cfg(chip), LTC6802::cfgRegisters);
+        dst += LTC6802::cfgRegisters;
+        memcpy(dst, stack.cells(chip), LTC6802::cellRegisters);
+        dst += LTC6802::cellRegisters;
+        memcpy(dst, stack.temperatures(chip), LTC6802::tmpRegisters);
+        dst += LTC6802::tmpRegisters;
+        memcpy(dst, stack.flags(chip), LTC6802::flgRegisters);
+        LTC6802::cellsDecode(stack.cells(chip), &staging.millivolts[chip * LTC6802::maxCells], true);
+        LTC6802::temperaturesDecode(stack.temperatures(chip), staging.temperatures[chip]);
+       }
+      staging.sequence = ++pushed;
+      staging.timestamp = micros();
+      std::lock_guard<std::mutex> lock(mutex);
+      if (count == capacity)
+       {
+        ++dropped;
+        if (overflow == LTC6802ScanQueue::dropNewest)
+         {
+          return false;
+         }
+        first = (first + 1) % capacity;
+        --count;
+       }
+      records[(first + count) % capacity] = staging;
+      ++count;
+      return true;
+     }
+
+    /**
+     * Copy out the oldest scan, see LTC6802ScanQueue::pop().
+     */
+    const LTC6802ScanQueue::Record *pop()
+     {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (count == 0)
+       {
+        return nullptr;
+       }
+      records[capacity + 1] = records[first];
+      first = (first + 1) % capacity;
+      --count;
+      return &records[capacity + 1];
+     }
+
+    /**
+     * Get scans dropped by the overflow policy.
+     */
+    unsigned long getDropped() const
+     {
+      return dropped;
+     }
+
+  private:
+    const byte numChips;
+    const size_t capacity;
+    const LTC6802ScanQueue::Overflow overflow;
+    std::vector<LTC6802ScanQueue::Record> records;  // capacity ring slots, producer staging, consumer copy
+    std::mutex mutex;
+    size_t first = 0;
+    size_t count = 0;
+    unsigned long pushed = 0;
+    unsigned long dropped = 0;
+ };
+
+
+/**
+ * Measured costs of one run.
+ */
+struct Result
+ {
+  double scansPerSecond;
+  double pushMeanNanos;
+  double pushMaxNanos;
+  unsigned long popped;
+  unsigned long dropped;
+ };
+
+
+/**
+ * Optimization barrier for the consumer work.
+ */
+static std::atomic<unsigned long> sink;
+
+
+/**
+ * Busy wait, stands in for processing in the consumer.
+ *
+ * @param nanos Duration
+ */
+static void work(const long nanos)
+ {
+  const auto end = std::chrono::steady_clock::now() + std::chrono::nanoseconds(nanos);
+  while (std::chrono::steady_clock::now() < end)
+   {
+   }
+ }
+
+
+/**
+ * Push scans from one thread while another one pops them.
+ *
+ * @param queue Queue under test
+ * @param stack Stack holding a scan
+ * @param scans Number of pushes
+ * @param consumerNanos Processing time per popped scan
+ * @param lossless Repeat rejected pushes until the scan is queued
+ * @return Costs
+ */
+template <typename Queue> static Result run(Queue &queue, const LTC6802StackBase &stack, const int scans, const long consumerNanos, const bool lossless)
+ {
+  std::atomic<bool> done(false);
+  unsigned long popped = 0;
+  std::thread consumer([&]()
+   {
+    for (;;)
+     {
+      // Drain what was pushed before done
+      const bool finished = done.load();
+      const LTC6802ScanQueue::Record *const record = queue.pop();
+      if (record == nullptr)
+       {
+        if (finished)
+         {
+          break;
+         }
+        std::this_thread::yield();
+        continue;
+       }
+      sink += *std::min_element(record->millivolts.begin(), record->millivolts.end());
+      work(consumerNanos);
+      ++popped;
+     }
+   });
+  double pushTotal = 0.0;
+  double pushMax = 0.0;
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < scans; ++i)
+   {
+    const auto pushStart = std::chrono::steady_clock::now();
+    while (!queue.push(stack) && lossless)
+     {
+      std::this_thread::yield();
+     }
+    const double nanos = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - pushStart).count();
+    pushTotal += nanos;
+    pushMax = std::max(pushMax, nanos);
+   }
+  const auto end = std::chrono::steady_clock::now();
+  done = true;
+  consumer.join();
+  Result result;
+  result.scansPerSecond = scans / std::chrono::duration<double>(end - start).count();
+  result.pushMeanNanos = pushTotal / scans;
+  result.pushMaxNanos = pushMax;
+  result.popped = popped;
+  result.dropped = 0;
+  return result;
+ }
+
+
+/**
+ * Print one result line.
+ *
+ * @param name Queue and policy
+ * @param result Costs
+ */
+static void print(const char *const name, const Result &result)
+ {
+  printf("%-28s %12.0f %10.0f %10.0f %9lu %9lu\n", name, result.scansPerSecond, result.pushMeanNanos, result.pushMaxNanos, result.popped, result.dropped);
+ }
+
+
+/**
+ * Run both queues with both overflow policies.
+ *
+ * @param stack Stack holding a scan
+ * @param numChips Number of chips
+ * @param scans Number of pushes
+ * @param capacity Queue capacity
+ * @param consumerNanos Processing time per popped scan
+ * @param lossless Repeat rejected pushes (drop newest only)
+ */
+static void compare(const LTC6802StackBase &stack, const byte numChips, const int scans, const size_t capacity, const long consumerNanos, const bool lossless)
+ {
+  printf("%-28s %12s %10s %10s %9s %9s\n", "queue", "scans/s", "push[ns]", "max[ns]", "popped", lossless ? "rejected" : "dropped");
+  const LTC6802ScanQueue::Overflow policies[] = {LTC6802ScanQueue::dropNewest, LTC6802ScanQueue::dropOldest};
+  for (const LTC6802ScanQueue::Overflow overflow : policies)
+   {
+    if (lossless && (overflow == LTC6802ScanQueue::dropOldest))
+     {
+      break;
+     }
+    const char *const policy = (overflow == LTC6802ScanQueue::dropOldest) ? "drop oldest" : "drop newest";
+    char name[32];
+    LTC6802ScanQueue lockFree(numChips, capacity, overflow);
+    Result result = run(lockFree, stack, scans, consumerNanos, lossless);
+    result.dropped = lockFree.getStatistics().dropped;
+    snprintf(name, sizeof(name), "lock free, %s", policy);
+    print(name, result);
+    MutexQueue locked(numChips, capacity, overflow);
+    result = run(locked, stack, scans, consumerNanos, lossless);
+    result.dropped = locked.getDropped();
+    snprintf(name, sizeof(name), "mutex, %s", policy);
+    print(name, result);
+   }
+ }
+
+
+int main(const int argc, const char *const argv[])
+ {
+  const int numChips = (argc > 1) ? atoi(argv[1]) : 16;
+  const int scans = (argc > 2) ? atoi(argv[2]) : 200000;
+  const size_t capacity = (argc > 3) ? (size_t)atoi(argv[3]) : 64;
+
+  std::vector<LTC6802Simulator> sims;
+  sims.reserve(numChips);
+  std::vector<LTC6802Simulator *> simPtrs;
+  for (int i = 0; i < numChips; ++i)
+   {
+    sims.emplace_back((byte)(0x80 + i));
+    for (byte cell = 0; cell < LTC6802::maxCells; ++cell)
+     {
+      sims.back().setCellVoltage(cell, 3300 + 10 * cell + i);
+     }
+    simPtrs.push_back(&sims.back());
+   }
+  LTC6802HostTransport chain(simPtrs.data(), numChips, LTC6802HostTransport::daisyChain);
+  std::vector<byte> stackBuffer(LTC6802StackBase::bufferSize(numChips));
+  LTC6802StackBase stack(chain, 10, numChips, stackBuffer.data());
+  LTC6802ScanPipeline pipeline(stack);
+  pipeline.begin();
+  pipeline.scan();
+
+  printf("%d chips, %d scans, capacity %u\n", numChips, scans, (unsigned int)capacity);
+  printf("\nthroughput, producer retries when full\n");
+  compare(stack, numChips, scans, capacity, 0, true);
+  printf("\nfast consumer\n");
+  compare(stack, numChips, scans, capacity, 0, false);
+  printf("\nslow consumer (20us per scan)\n");
+  compare(stack, numChips, scans / 10, capacity, 20000, false);
+
+  // The consumer holds a popped record while the producer overruns the queue
+  LTC6802ScanQueue overrun(numChips, capacity, LTC6802ScanQueue::dropOldest);
+  overrun.push(stack);
+  const LTC6802ScanQueue::Record *const held = overrun.pop();
+  const unsigned long overrunScans = 3 * capacity;
+  for (unsigned long i = 0; i < overrunScans; ++i)
+   {
+    overrun.push(stack);
+   }
+  bool newest = (held->sequence == 1);
+  unsigned long expected = overrunScans + 2 - capacity;
+  for (const LTC6802ScanQueue::Record *record = overrun.pop(); record != nullptr; record = overrun.pop())
+   {
+    newest = newest && (record->sequence == expected);
+    ++expected;
+   }
+  newest = newest && (expected == overrunScans + 2);
+  printf("\nslow consumer, drop oldest: %s, %lu dropped\n", newest ? "newest scans popped in order" : "FAILED", overrun.getStatistics().dropped);
+  if (!newest)
+   {
+    return 1;
+   }
+
+  // Acquisition thread running the scan loop, processing thread checking the sequence
+  const int loopScans = 2000;
+  LTC6802ScanQueue queue(numChips, capacity);
+  std::atomic<bool> done(false);
+  unsigned long received = 0;
+  unsigned long gaps = 0;
+  std::thread processing([&]()
+   {
+    unsigned long last = 0;
+    for (;;)
+     {
+      // Drain what was pushed before done
+      const bool finished = done.load();
+      const LTC6802ScanQueue::Record *const record = queue.pop();
+      if (record == nullptr)
+       {
+        if (finished)
+         {
+          break;
+         }
+        std::this_thread::yield();
+        continue;
+       }
+      gaps += (record->sequence != last + 1) ? 1 : 0;
+      last = record->sequence;
+      ++received;
+     }
+   });
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < loopScans; ++i)
+   {
+    pipeline.scan();
+    queue.push(stack);
+   }
+  const auto end = std::chrono::steady_clock::now();
+  done = true;
+  processing.join();
+  const LTC6802ScanQueue::Statistics statistics = queue.getStatistics();
+  printf("\nscan loop: %d pipelined scans in %.1fms host time, %lu received, %lu dropped, %lu gaps\n", loopScans,
+    std::chrono::duration<double, std::milli>(end - start).count(), received, statistics.dropped, gaps);
+  return 0;
+ }
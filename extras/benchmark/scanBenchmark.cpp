@@ -0,0 +1,381 @@
+/**
+ * Copyright 2017, 2019 Dipl.-Inform. Kai Hofmann
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Full pack scan benchmark against simulated LTC6802 chips.
+//
+// Build and run on the host:
+//
+//   g++ -std=c++17 -O2 -I../../src -I../host ../../src/*.cpp ../host/*.cpp scanBenchmark.cpp -o scanBenchmark
+//   ./scanBenchmark [chips] [scans]
+//
+// Reports bus traffic, modeled bus time and virtual wall time (including
+// conversion waits) per full pack scan, plus the host CPU time spent in
+// the driver.
+//
+// Add -DLTC6802_PROFILE to also print the per operation timings of the
+// instrumentation hooks in virtual microseconds, in the same format the
+// stackMonitor example prints on target.
+#include <LTC6802.h>
+#include <LTC6802Stack.h>
+#include <LTC6802CellScheduler.h>
+#include <LTC6802SelfTest.h>
+#include <LTC6802Monitor.h>
+#include <LTC6802Acquisition.h>
+#include <LTC6802MultiStack.h>
+#include <LTC6802ScanPipeline.h>
+#include <LTC6802Profile.h>
+#include <LTC6802Simulator.h>
+#include <LTC6802HostTransport.h>
+#include <chrono>
+#include <stdlib.h>
+#include <vector>
+
+
+/**
+ * Measured costs of one scan variant.
+ */
+struct Result
+ {
+  double bytes;
+  double frames;
+  double calls;
+  double busMicros;
+  double wallMicros;
+  double hostNanos;
+ };
+
+
+/**
+ * Run scans and average the costs.
+ *
+ * @param bus Host transport
+ * @param scans Number of scans
+ * @param scan Scan function
+ * @return Average costs per scan
+ */
+template <typename Scan> static Result run(LTC6802HostTransport &bus, const int scans, Scan scan)
+ {
+  bus.resetStatistics();
+  const uint64_t virtualStart = LTC6802HostClock::nanos();
+  const auto hostStart = std::chrono::steady_clock::now();
+  for (int i = 0; i < scans; ++i)
+   {
+    scan();
+   }
+  const auto hostEnd = std::chrono::steady_clock::now();
+  const LTC6802HostTransport::Statistics &stats = bus.getStatistics();
+  Result result;
+  result.bytes = (double)stats.bytes / scans;
+  result.frames = (double)stats.frames / scans;
+  result.calls = (double)stats.calls / scans;
+  result.busMicros = stats.busNanos / 1000.0 / scans;
+  result.wallMicros = (LTC6802HostClock::nanos() - virtualStart) / 1000.0 / scans;
+  result.hostNanos = std::chrono::duration<double, std::nano>(hostEnd - hostStart).count() / scans;
+  return result;
+ }
+
+
+/**
+ * Print one result line.
+ *
+ * @param name Scan variant
+ * @param result Averaged costs
+ */
+static void print(const char *const name, const Result &result)
+ {
+  printf("%-28s %8.1f %7.1f %7.1f %10.1f %11.1f %10.0f\n", name, result.bytes, result.frames, result.calls, result.busMicros, result.wallMicros, result.hostNanos);
+ }
+
+
+int main(const int argc, const char *const argv[])
+ {
+  const int numChips = (argc > 1) ? atoi(argv[1]) : 16;
+  const int scans = (argc > 2) ? atoi(argv[2]) : 100;
+
+  std::vector<LTC6802Simulator> sims;
+  sims.reserve(numChips);
+  std::vector<LTC6802Simulator *> simPtrs;
+  for (int i = 0; i < numChips; ++i)
+   {
+    sims.emplace_back((byte)(0x80 + i));
+    for (byte cell = 0; cell < LTC6802::maxCells; ++cell)
+     {
+      sims.back().setCellVoltage(cell, 3300 + 10 * cell + i);
+     }
+    simPtrs.push_back(&sims.back());
+   }
+  LTC6802HostTransport bus(simPtrs.data(), numChips, LTC6802HostTransport::addressed);
+  LTC6802HostTransport chain(simPtrs.data(), numChips, LTC6802HostTransport::daisyChain);
+
+  std::vector<LTC6802> chips;
+  chips.reserve(numChips);
+  for (int i = 0; i < numChips; ++i)
+   {
+    chips.emplace_back(bus, (byte)(0x80 + i), 10);
+    chips.back().cfgSetCDC(1);
+    chips.back().cfgSetMCI(0x0fff);
+   }
+
+  printf("%d chips, %d scans, 1MHz SPI\n", numChips, scans);
+  printf("%-28s %8s %7s %7s %10s %11s %10s\n", "scan", "bytes", "frames", "calls", "bus[us]", "wall[us]", "host[ns]");
+
+  const auto chipScan = [&]()
+   {
+    for (LTC6802 &chip : chips)
+     {
+      chip.cfgWrite(false);
+      chip.temperatureMeasure();
+      chip.temperatureRead();
+      chip.cellsMeasure();
+      chip.cellsRead();
+      chip.flagsRead();
+     }
+   };
+  print("per chip (batteryMonitor)", run(bus, scans, chipScan));
+
+  print("single chip RDCV frame", run(bus, scans, [&]()
+   {
+    chips[0].cellsRead();
+   }));
+  printf("%-28s %8s %7s %7s %10.1f\n", "  ideal (21 bytes clocked)", "", "", "", 21 * 8.0);
+
+  std::vector<byte> groupBuffer(LTC6802StackBase::bufferSize(numChips));
+  LTC6802StackBase group(bus, 10, 0x80, numChips, groupBuffer.data());
+  std::vector<byte> stackBuffer(LTC6802StackBase::bufferSize(numChips));
+  LTC6802StackBase stack(chain, 10, numChips, stackBuffer.data());
+  for (int i = 0; i < numChips; ++i)
+   {
+    group.cfg(i)[0] = stack.cfg(i)[0] = 0x61; // GPIO pull downs off, CDC 1
+    group.cfg(i)[2] = stack.cfg(i)[2] = 0xf0; // Mask all cell interrupts
+    group.cfg(i)[3] = stack.cfg(i)[3] = 0xff;
+   }
+
+  print("addressed stack, broadcast", run(bus, scans, [&]()
+   {
+    group.cfgWrite();
+    group.temperatureMeasure();
+    group.temperatureRead();
+    group.cellsMeasure();
+    group.cellsRead();
+    group.flagsRead();
+   }));
+
+  const auto stackScan = [&]()
+   {
+    stack.cfgWrite();
+    stack.temperatureMeasure();
+    stack.temperatureRead();
+    stack.cellsMeasure();
+    stack.cellsRead();
+    stack.flagsRead();
+   };
+  print("daisy chain stack", run(chain, scans, stackScan));
+
+  print("daisy chain, keep alive", run(chain, scans, [&]()
+   {
+    stack.keepAlive();
+    stack.temperatureMeasure();
+    stack.temperatureRead();
+    stack.cellsMeasure();
+    stack.cellsRead();
+    stack.flagsRead();
+   }));
+
+  // Scans every 50ms, the main loop does 1ms of other work per cycle in between. The self test
+  // converts in that time and must not run into the next scan; the driver blocks only in its calls.
+  std::vector<byte> selfTestResults(numChips);
+  std::vector<byte> selfTestFrame(LTC6802StackBase::selfTestFrameSize(numChips));
+  LTC6802SelfTest selfTest(stack, selfTestResults.data(), selfTestFrame.data());
+  for (int withSelfTest = 0; withSelfTest < 2; ++withSelfTest)
+   {
+    uint64_t blocked = 0;
+    for (int i = 0; i < scans; ++i)
+     {
+      const uint64_t periodEnd = LTC6802HostClock::nanos() + 50000000U;
+      uint64_t start = LTC6802HostClock::nanos();
+      stackScan();
+      blocked += LTC6802HostClock::nanos() - start;
+      while ((LTC6802HostClock::nanos() < periodEnd) || selfTest.isRunning())
+       {
+        if (withSelfTest != 0)
+         {
+          start = LTC6802HostClock::nanos();
+          selfTest.step();
+          blocked += LTC6802HostClock::nanos() - start;
+         }
+        delayMicroseconds(1000);
+       }
+     }
+    printf("50ms scan period%s: driver blocks %.1fus per scan\n", (withSelfTest != 0) ? ", self test" : "", blocked / 1000.0 / scans);
+   }
+  printf("  %lu self test rounds over all chips\n", selfTest.getRounds());
+
+  chain.setClockLimit(4000000);
+  const unsigned long clock = stack.calibrateClock(500000, 16000000);
+  printf("calibrated clock %lu Hz (modeled wiring limit 4MHz)\n", clock);
+  print("daisy chain stack, calibrated", run(chain, scans, stackScan));
+  LTC6802ScanPipeline pipeline(stack);
+  pipeline.begin();
+  print("daisy chain, pipelined", run(chain, scans, [&]()
+   {
+    pipeline.scan();
+   }));
+  printf("pipelined scan period %luus (cells, temperatures, flags, config)\n", pipeline.getPeriod());
+
+  printf("\nhot cell sampling, daisy chain at %lu Hz\n", clock);
+  const Result fullScan = run(chain, scans, [&]()
+   {
+    stack.cellsMeasure();
+    stack.cellsRead();
+   });
+  print("full cell scan", fullScan);
+  std::vector<uint16_t> millivolts(numChips * LTC6802::maxCells);
+  const Result fastSample = run(chain, scans, [&]()
+   {
+    stack.cellMeasure(5);
+    stack.cellRead(5, millivolts.data());
+   });
+  print("single cell sample", fastSample);
+  LTC6802CellScheduler scheduler(stack, millivolts.data(), 4);
+  scheduler.watch(1 << 5);
+  const Result scheduled = run(chain, scans * 5, [&]()
+   {
+    scheduler.step();
+   });
+  print("scheduler slot (4 fast : 1)", scheduled);
+  printf("hot cell latency %.0fus -> %.0fus (%.1fx), samples/s %.0f -> %.0f (scheduled, 4 fast per full scan)\n",
+    fullScan.wallMicros, fastSample.wallMicros, fullScan.wallMicros / fastSample.wallMicros,
+    1e6 / fullScan.wallMicros, 1e6 / scheduled.wallMicros);
+
+  printf("\ninterrupt driven acquisition, daisy chain at %lu Hz\n", clock);
+  std::vector<byte> snapshotBuffer(LTC6802Snapshot::bufferSize(numChips));
+  LTC6802Snapshot snapshot(numChips, snapshotBuffer.data());
+  LTC6802Acquisition acquisition(stack, snapshot);
+  chain.setEdgeHandler([](void *const context)
+   {
+    static_cast<LTC6802Acquisition *>(context)->onEdge();
+   }, &acquisition);
+  acquisition.begin();
+  const Result acquired = run(chain, scans, [&]()
+   {
+    // The main loop only checks for results, SDO edges drive the reads
+    while (!snapshot.update())
+     {
+      delayMicroseconds(100);
+      chain.injectEdges();
+     }
+   });
+  acquisition.end();
+  chain.setEdgeHandler(0, 0);
+  print("SDO edge per result", acquired);
+  printf("bus traffic per cell scan %.1f -> %.1f bytes, %.1f -> %.1f frames (polled -> interrupt driven)\n",
+    fullScan.bytes, acquired.bytes, fullScan.frames, acquired.frames);
+
+  printf("\n4 strings of %d chips on separate buses, daisy chain at %lu Hz\n", numChips, clock);
+  const int numStrings = 4;
+  std::vector<LTC6802Simulator> stringSims;
+  stringSims.reserve(numStrings * numChips);
+  std::vector<LTC6802Simulator *> stringSimPtrs;
+  for (int i = 0; i < numStrings * numChips; ++i)
+   {
+    stringSims.emplace_back((byte)0x80);
+    stringSimPtrs.push_back(&stringSims.back());
+   }
+  std::vector<LTC6802HostTransport> stringBuses;
+  stringBuses.reserve(numStrings);
+  std::vector<std::vector<byte>> stringBuffers;
+  std::vector<LTC6802StackBase> strings;
+  strings.reserve(numStrings);
+  std::vector<LTC6802StackBase *> stringPtrs;
+  for (int i = 0; i < numStrings; ++i)
+   {
+    stringBuses.emplace_back(&stringSimPtrs[i * numChips], numChips, LTC6802HostTransport::daisyChain);
+    stringBuses.back().setClock(clock);
+    stringBuffers.emplace_back(LTC6802StackBase::bufferSize(numChips));
+    strings.emplace_back(stringBuses.back(), 10, numChips, stringBuffers.back().data());
+    stringPtrs.push_back(&strings.back());
+   }
+  // Traffic of all string buses
+  const auto runStrings = [&](auto scan)
+   {
+    for (LTC6802HostTransport &stringBus : stringBuses)
+     {
+      stringBus.resetStatistics();
+     }
+    Result result = run(stringBuses[0], scans, scan);
+    for (int i = 1; i < numStrings; ++i)
+     {
+      const LTC6802HostTransport::Statistics &stats = stringBuses[i].getStatistics();
+      result.bytes += (double)stats.bytes / scans;
+      result.frames += (double)stats.frames / scans;
+      result.calls += (double)stats.calls / scans;
+      result.busMicros += stats.busNanos / 1000.0 / scans;
+     }
+    return result;
+   };
+  const Result sequential = runStrings([&]()
+   {
+    for (LTC6802StackBase &string : strings)
+     {
+      string.cellsMeasure();
+      string.cellsRead();
+     }
+   });
+  print("one string after another", sequential);
+  LTC6802MultiStack multiStack(stringPtrs.data(), numStrings);
+  multiStack.begin();
+  const Result overlapped = runStrings([&]()
+   {
+    multiStack.scan();
+   });
+  print("overlapped round robin", overlapped);
+  printf("round over all strings %.0fus -> %.0fus (%.1fx)\n", sequential.wallMicros, overlapped.wallMicros, sequential.wallMicros / overlapped.wallMicros);
+
+  printf("\ncomparator monitoring, daisy chain, 100ms loop\n");
+  const Result scanned = run(chain, scans, [&]()
+   {
+    stack.keepAlive();
+    stack.cellsMeasure();
+    stack.cellsRead();
+    stack.flagsRead();
+    delay(100);
+   });
+  print("full scan every loop", scanned);
+  LTC6802Monitor monitor(stack);
+  monitor.begin(3000, 4200);
+  const Result monitored = run(chain, scans, [&]()
+   {
+    monitor.step();
+    delay(100);
+   });
+  print("PLINT poll, scan every 10s", monitored);
+  printf("routine bus traffic %.1f -> %.1f bytes per loop (%.1fx less)\n", scanned.bytes, monitored.bytes, scanned.bytes / monitored.bytes);
+
+  #ifdef LTC6802_PROFILE
+    printf("\noperation profile [us]: name calls min mean max\n");
+    LTC6802Profile::reset();
+    run(bus, scans, chipScan);
+    run(chain, scans, stackScan);
+    pipeline.begin();
+    run(chain, scans, [&]()
+     {
+      pipeline.scan();
+     });
+    LTC6802Profile::debugOutput();
+  #endif
+
+  return 0;
+ }
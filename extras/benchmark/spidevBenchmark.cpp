@@ -0,0 +1,188 @@
+/**
+ * Copyright 2017, 2019 Dipl.-Inform. Kai Hofmann
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Syscalls per scan of the Linux spidev transport.
+//
+// Build and run on the host:
+//
+//   g++ -std=c++17 -O2 -I../../src -I../host -I../gateway ../../src/*.cpp ../host/*.cpp ../gateway/*.cpp spidevBenchmark.cpp -o spidevBenchmark
+//   ./spidevBenchmark [chips] [scans]
+//
+// Runs LTC6802SpidevTransport against simulated chips through the fake
+// ioctl layer (LTC6802FakeSpidev) and counts SPI_IOC_MESSAGE ioctls per
+// full scan (temperatures, cells, flags), split into conversion starts,
+// PLADC polls and register reads. Compares one ioctl per chip select frame
+// with batched group reads and with one batched scanRead().
+#include <LTC6802.h>
+#include <LTC6802Stack.h>
+#include <LTC6802Simulator.h>
+#include <LTC6802HostTransport.h>
+#include <LTC6802FakeSpidev.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+
+/**
+ * Measured costs of one scan variant.
+ */
+struct Result
+ {
+  double starts;
+  double polls;
+  double reads;
+  double frames;
+  double transfers;
+  double bytes;
+  double busMicros;
+ };
+
+
+/**
+ * Run scans and average the costs.
+ *
+ * @param chips Host transport of the simulated chips
+ * @param spi Spidev transport under test
+ * @param stack Stack on the spidev transport
+ * @param scans Number of scans
+ * @param scanRead true : one scanRead(), false : one read per register group
+ * @return Average costs per scan
+ */
+static Result run(LTC6802HostTransport &chips, LTC6802FakeSpidev &spi, LTC6802StackBase &stack, const int scans, const bool scanRead)
+ {
+  unsigned long starts = 0;
+  unsigned long polls = 0;
+  unsigned long reads = 0;
+  const auto counted = [&](unsigned long &counter, const auto operation)
+   {
+    const unsigned long before = spi.getStatistics().ioctls;
+    operation();
+    counter += spi.getStatistics().ioctls - before;
+   };
+  const auto wait = [&]()
+   {
+    while (stack.poll() == LTC6802::busy)
+     {
+      delayMicroseconds(1000);
+     }
+   };
+  chips.resetStatistics();
+  spi.resetStatistics();
+  for (int i = 0; i < scans; ++i)
+   {
+    counted(starts, [&]() {stack.temperatureMeasure();});
+    counted(polls, wait);
+    if (!scanRead)
+     {
+      counted(reads, [&]() {stack.temperatureRead();});
+     }
+    counted(starts, [&]() {stack.cellsMeasure();});
+    counted(polls, wait);
+    if (scanRead)
+     {
+      counted(reads, [&]() {stack.scanRead();});
+     }
+    else
+     {
+      counted(reads, [&]() {stack.cellsRead(); stack.flagsRead();});
+     }
+   }
+  const LTC6802SpidevTransport::Statistics &stats = spi.getStatistics();
+  Result result;
+  result.starts = (double)starts / scans;
+  result.polls = (double)polls / scans;
+  result.reads = (double)reads / scans;
+  result.frames = (double)stats.frames / scans;
+  result.transfers = (double)stats.transfers / scans;
+  result.bytes = (double)stats.bytes / scans;
+  result.busMicros = chips.getStatistics().busNanos / 1000.0 / scans;
+  return result;
+ }
+
+
+/**
+ * Print one result line.
+ *
+ * @param name Scan variant
+ * @param result Averaged costs
+ */
+static void print(const char *const name, const Result &result)
+ {
+  printf("%-30s %7.1f %6.1f %6.1f %6.1f %7.1f %9.1f %7.1f %9.1f\n", name, result.starts + result.polls + result.reads, result.starts, result.polls,
+    result.reads, result.frames, result.transfers, result.bytes, result.busMicros);
+ }
+
+
+int main(const int argc, const char *const argv[])
+ {
+  const int numChips = (argc > 1) ? atoi(argv[1]) : 16;
+  const int scans = (argc > 2) ? atoi(argv[2]) : 100;
+
+  std::vector<LTC6802Simulator> sims;
+  sims.reserve(numChips);
+  std::vector<LTC6802Simulator *> simPtrs;
+  for (int i = 0; i < numChips; ++i)
+   {
+    sims.emplace_back((byte)(0x80 + i));
+    for (byte cell = 0; cell < LTC6802::maxCells; ++cell)
+     {
+      sims.back().setCellVoltage(cell, 3300 + 10 * cell + i);
+     }
+    simPtrs.push_back(&sims.back());
+   }
+
+  printf("%d chips, %d scans, ioctls per scan\n", numChips, scans);
+  printf("%-30s %7s %6s %6s %6s %7s %9s %7s %9s\n", "scan", "ioctls", "start", "poll", "read", "frames", "transfers", "bytes", "bus[us]");
+  const LTC6802HostTransport::Topology topologies[] = {LTC6802HostTransport::addressed, LTC6802HostTransport::daisyChain};
+  for (const LTC6802HostTransport::Topology topology : topologies)
+   {
+    const bool addressed = (topology == LTC6802HostTransport::addressed);
+    LTC6802HostTransport chips(simPtrs.data(), numChips, topology);
+    LTC6802FakeSpidev spi(chips);
+    std::vector<byte> stackBuffer(LTC6802StackBase::bufferSize(numChips));
+    LTC6802StackBase stack(spi, 0, addressed ? 0x80 : 0, numChips, stackBuffer.data());
+    for (int i = 0; i < numChips; ++i)
+     {
+      stack.cfg(i)[0] = 0x61; // GPIO pull downs off, CDC 1
+     }
+    stack.cfgWrite();
+
+    char name[40];
+    spi.setBatching(false);
+    snprintf(name, sizeof(name), "%s, ioctl per frame", addressed ? "addressed" : "daisy chain");
+    print(name, run(chips, spi, stack, scans, false));
+    spi.setBatching(true);
+    snprintf(name, sizeof(name), "%s, batched groups", addressed ? "addressed" : "daisy chain");
+    print(name, run(chips, spi, stack, scans, false));
+    snprintf(name, sizeof(name), "%s, scanRead", addressed ? "addressed" : "daisy chain");
+    print(name, run(chips, spi, stack, scans, true));
+
+    // Same registers as through the host transport directly
+    std::vector<byte> checkBuffer(LTC6802StackBase::bufferSize(numChips));
+    LTC6802StackBase check(chips, 10, addressed ? 0x80 : 0, numChips, checkBuffer.data());
+    check.cellsMeasure();
+    check.cellsRead();
+    stack.cellsMeasure();
+    const LTC6802::Status status = stack.scanRead();
+    bool same = (status == LTC6802::ok);
+    for (int i = 0; same && (i < numChips); ++i)
+     {
+      same = (memcmp(check.cells(i), stack.cells(i), LTC6802::cellRegisters) == 0);
+     }
+    printf("  cells match the direct host transport: %s\n", same ? "yes" : "NO");
+   }
+  return 0;
+ }
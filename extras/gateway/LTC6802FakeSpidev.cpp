@@ -0,0 +1,81 @@
+/**
+ * Copyright 2017, 2019 Dipl.-Inform. Kai Hofmann
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <LTC6802FakeSpidev.h>
+#include <errno.h>
+#include <string.h>
+#include <sys/ioctl.h>
+
+
+LTC6802FakeSpidev::LTC6802FakeSpidev(LTC6802HostTransport &chips, const byte csPin)
+ : chips(chips), csPin(csPin)
+ {
+  chips.attach(csPin);
+ }
+
+
+int LTC6802FakeSpidev::control(const unsigned long request, void *const arg)
+ {
+  if (_IOC_TYPE(request) != SPI_IOC_MAGIC)
+   {
+    errno = ENOTTY;
+    return -1;
+   }
+  if (request == SPI_IOC_WR_MAX_SPEED_HZ)
+   {
+    chips.setClock(*(const uint32_t *)arg);
+    return 0;
+   }
+  if (_IOC_NR(request) != _IOC_NR(SPI_IOC_MESSAGE(1)))
+   {
+    return 0;
+   }
+  const struct spi_ioc_transfer *const transfers = (const struct spi_ioc_transfer *)arg;
+  const size_t count = _IOC_SIZE(request) / sizeof(struct spi_ioc_transfer);
+  int total = 0;
+  for (size_t i = 0; i < count; ++i)
+   {
+    const struct spi_ioc_transfer &transfer = transfers[i];
+    if ((transfer.speed_hz != 0) && (transfer.speed_hz != chips.getClock()))
+     {
+      chips.setClock(transfer.speed_hz);
+     }
+    if (!selected)
+     {
+      chips.select(csPin);
+      selected = true;
+     }
+    // Null tx shifts out zeros, null rx discards
+    buffer.assign(transfer.len, 0);
+    if (transfer.tx_buf != 0)
+     {
+      memcpy(buffer.data(), (const void *)(uintptr_t)transfer.tx_buf, transfer.len);
+     }
+    chips.transfer(buffer.data(), transfer.len);
+    if (transfer.rx_buf != 0)
+     {
+      memcpy((void *)(uintptr_t)transfer.rx_buf, buffer.data(), transfer.len);
+     }
+    total += (int)transfer.len;
+    // cs_change ends the frame within a message, on the last transfer it keeps the chip selected
+    const bool last = (i + 1 == count);
+    if ((transfer.cs_change != 0) != last)
+     {
+      chips.deselect(csPin);
+      selected = false;
+     }
+   }
+  return total;
+ }
@@ -0,0 +1,76 @@
+/**
+ * Copyright 2017, 2019 Dipl.-Inform. Kai Hofmann
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef LTC6802FAKESPIDEV_H_INCLUDED_
+  #define LTC6802FAKESPIDEV_H_INCLUDED_
+
+  #include <LTC6802SpidevTransport.h>
+  #include <LTC6802HostTransport.h>
+  #include <vector>
+
+  /**
+   * Spidev transport whose ioctls are played against simulated chips.
+   *
+   * Replaces the kernel side of SPI_IOC_MESSAGE: the transfers of a message
+   * are clocked through an LTC6802HostTransport, chip select follows
+   * cs_change like the spidev driver does. Setup ioctls only take over the
+   * clock. Needs no device node, so the Linux code path including the
+   * syscall count can be tested and benchmarked on any host.
+   */
+  class LTC6802FakeSpidev : public LTC6802SpidevTransport
+   {
+    public:
+      /**
+       * Constructor.
+       *
+       * @param chips Host transport with the simulated chips
+       * @param csPin Chip select pin used on the host transport
+       */
+      explicit LTC6802FakeSpidev(LTC6802HostTransport &chips, byte csPin = 10);
+
+    protected:
+      /**
+       * Play one ioctl against the simulated chips.
+       *
+       * @param request ioctl request
+       * @param arg Request argument
+       * @return Bytes clocked for messages, 0 for setup, -1 (errno ENOTTY) for other requests
+       */
+      int control(unsigned long request, void *arg) override;
+
+    private:
+      /**
+       * Simulated chips.
+       */
+      LTC6802HostTransport &chips;
+
+      /**
+       * Chip select pin used on the host transport.
+       */
+      byte csPin;
+
+      /**
+       * Chip select is held across messages.
+       */
+      bool selected = false;
+
+      /**
+       * Bytes of the transfer being clocked.
+       */
+      std::vector<byte> buffer;
+
+   };
+
+#endif
@@ -0,0 +1,143 @@
+/**
+ * Copyright 2017, 2019 Dipl.-Inform. Kai Hofmann
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <LTC6802ScanQueue.h>
+#include <algorithm>
+#include <string.h>
+
+
+LTC6802ScanQueue::LTC6802ScanQueue(const byte numChips, const size_t capacity, const Overflow overflow)
+ : numChips(numChips), capacity(capacity), overflow(overflow), records(capacity + 2), slots(capacity), current(capacity + 1), spare(capacity)
+ {
+  for (Record &record : records)
+   {
+    record.sequence = 0;
+    record.timestamp = 0;
+    record.registers.assign((size_t)numChips * chipBytes, 0);
+    record.millivolts.assign((size_t)numChips * LTC6802::maxCells, 0);
+    record.temperatures.assign(numChips, LTC6802::Temperatures());
+   }
+  for (size_t i = 0; i < capacity; ++i)
+   {
+    slots[i].store(slot(0, i), std::memory_order_relaxed);
+   }
+ }
+
+
+bool LTC6802ScanQueue::push(const LTC6802StackBase &stack)
+ {
+  const size_t index = tail.load(std::memory_order_relaxed);
+  const unsigned long sequence = pushed.fetch_add(1, std::memory_order_relaxed) + 1;
+  if ((overflow == dropNewest) && (index - headCache >= capacity))
+   {
+    headCache = head.load(std::memory_order_acquire);
+    if (index - headCache >= capacity)
+     {
+      dropped.fetch_add(1, std::memory_order_relaxed);
+      return false;
+     }
+   }
+  Record &record = records[spare];
+  for (byte chip = 0; chip < numChips; ++chip)
+   {
+    // Same order as the Record accessors
+    byte *dst = &record.registers[chip * chipBytes];
+    memcpy(dst, stack.cfg(chip), LTC6802::cfgRegisters);
+    dst += LTC6802::cfgRegisters;
+    memcpy(dst, stack.cells(chip), LTC6802::cellRegisters);
+    dst += LTC6802::cellRegisters;
+    memcpy(dst, stack.temperatures(chip), LTC6802::tmpRegisters);
+    dst += LTC6802::tmpRegisters;
+    memcpy(dst, stack.flags(chip), LTC6802::flgRegisters);
+    LTC6802::cellsDecode(stack.cells(chip), &record.millivolts[chip * LTC6802::maxCells], true);
+    LTC6802::temperaturesDecode(stack.temperatures(chip), record.temperatures[chip]);
+   }
+  record.sequence = sequence;
+  record.timestamp = micros();
+  // Gets back the record the consumer left in the slot, or with dropOldest the oldest scan if it was not popped
+  const uint64_t replaced = slots[index % capacity].exchange(slot(index + 1, spare), std::memory_order_acq_rel);
+  if ((replaced >> recordBits) != 0)
+   {
+    dropped.fetch_add(1, std::memory_order_relaxed);
+   }
+  spare = (size_t)(replaced & ((1U << recordBits) - 1));
+  tail.store(index + 1, std::memory_order_release);
+  return true;
+ }
+
+
+const LTC6802ScanQueue::Record *LTC6802ScanQueue::pop()
+ {
+  size_t index = head.load(std::memory_order_relaxed);
+  for (;;)
+   {
+    if (index >= tailCache)
+     {
+      tailCache = tail.load(std::memory_order_acquire);
+      if (index >= tailCache)
+       {
+        head.store(index, std::memory_order_release);
+        return nullptr;
+       }
+     }
+    // Scans overwritten by dropOldest are gone, continue with the oldest one left
+    if (tailCache - index > capacity)
+     {
+      index = tailCache - capacity;
+     }
+    std::atomic<uint64_t> &target = slots[index % capacity];
+    uint64_t value = target.load(std::memory_order_acquire);
+    // Hand back the held record as consumed and take the scan, unless the producer just overwrote it
+    if (((value >> recordBits) == index + 1) && target.compare_exchange_strong(value, slot(0, current), std::memory_order_acq_rel, std::memory_order_acquire))
+     {
+      current = (size_t)(value & ((1U << recordBits) - 1));
+      head.store(index + 1, std::memory_order_release);
+      popped.fetch_add(1, std::memory_order_relaxed);
+      return &records[current];
+     }
+    tailCache = tail.load(std::memory_order_acquire);
+    ++index;
+   }
+ }
+
+
+size_t LTC6802ScanQueue::size() const
+ {
+  const size_t first = head.load(std::memory_order_acquire);
+  const size_t last = tail.load(std::memory_order_acquire);
+  return (last > first) ? std::min(last - first, capacity) : 0;
+ }
+
+
+size_t LTC6802ScanQueue::getCapacity() const
+ {
+  return capacity;
+ }
+
+
+LTC6802ScanQueue::Statistics LTC6802ScanQueue::getStatistics() const
+ {
+  Statistics statistics;
+  statistics.pushed = pushed.load(std::memory_order_relaxed);
+  statistics.popped = popped.load(std::memory_order_relaxed);
+  statistics.dropped = dropped.load(std::memory_order_relaxed);
+  return statistics;
+ }
+
+
+uint64_t LTC6802ScanQueue::slot(const size_t tag, const size_t record)
+ {
+  return ((uint64_t)tag << recordBits) | record;
+ }
@@ -0,0 +1,297 @@
+/**
+ * Copyright 2017, 2019 Dipl.-Inform. Kai Hofmann
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef LTC6802SCANQUEUE_H_INCLUDED_
+  #define LTC6802SCANQUEUE_H_INCLUDED_
+
+  #include <LTC6802.h>
+  #include <LTC6802Stack.h>
+  #include <atomic>
+  #include <vector>
+
+  /**
+   * Bounded lock free queue of complete stack scans for a Linux gateway.
+   *
+   * One acquisition thread pushes each finished scan of the stack scan loop,
+   * one processing thread (BMS logic, logging) pops them in order. The
+   * records are allocated once by the constructor and never copied: each
+   * side owns one record outside the ring. push() fills its spare record
+   * (raw registers plus decoded cells and temperatures) and exchanges it
+   * with the ring slot, the record it gets back is its next spare. pop()
+   * swaps the record the consumer holds into the slot of the oldest scan in
+   * one atomic step, so a record held by a slow consumer never blocks a
+   * slot. Neither side ever takes a lock or waits: when the consumer falls
+   * behind the overflow policy drops the oldest queued scan or the new one
+   * and counts it.
+   *
+   * Each slot holds the record number and the push index of its scan, so a
+   * pop of a scan the producer overwrote at the same time fails and moves on
+   * to the next one. The indices sit on separate cache lines so the two
+   * threads do not share a line on every push and pop.
+   */
+  class LTC6802ScanQueue
+   {
+    public:
+      /**
+       * Bytes per chip in a record (configuration, cell, temperature and flag registers).
+       */
+      static const byte chipBytes = LTC6802::cfgRegisters + LTC6802::cellRegisters + LTC6802::tmpRegisters + LTC6802::flgRegisters;
+
+      /**
+       * Cache line size the indices are padded to.
+       */
+      static const size_t cacheLine = 64;
+
+      /**
+       * What push() does when the queue is full.
+       */
+      enum Overflow
+       {
+        /**
+         * Drop the oldest queued scan, the consumer always gets the latest ones.
+         */
+        dropOldest,
+
+        /**
+         * Drop the new scan, the consumer gets an unbroken run up to the overflow.
+         */
+        dropNewest
+       };
+
+      /**
+       * One scan of the whole stack.
+       */
+      struct alignas(cacheLine) Record
+       {
+        /**
+         * Number of the scan, counting all pushes including dropped ones.
+         */
+        unsigned long sequence;
+
+        /**
+         * micros() at push.
+         */
+        unsigned long timestamp;
+
+        /**
+         * Registers, chipBytes per chip in the order of the accessors below.
+         */
+        std::vector<byte> registers;
+
+        /**
+         * Cell voltages in mV, 12 per chip, chip 0 first.
+         */
+        std::vector<uint16_t> millivolts;
+
+        /**
+         * Decoded temperatures, one per chip.
+         */
+        std::vector<LTC6802::Temperatures> temperatures;
+
+        /**
+         * Get configuration registers of a chip.
+         *
+         * @param chip Chip index, 0 : bottom chip
+         * @return 6 configuration registers
+         */
+        const byte *cfg(const byte chip) const {return (&registers[chip * chipBytes]);}
+
+        /**
+         * Get cell registers of a chip.
+         *
+         * @param chip Chip index, 0 : bottom chip
+         * @return 18 cell registers
+         */
+        const byte *cells(const byte chip) const {return (&registers[chip * chipBytes + LTC6802::cfgRegisters]);}
+
+        /**
+         * Get temperature registers of a chip.
+         *
+         * @param chip Chip index, 0 : bottom chip
+         * @return 5 temperature registers
+         */
+        const byte *tmp(const byte chip) const {return (&registers[chip * chipBytes + LTC6802::cfgRegisters + LTC6802::cellRegisters]);}
+
+        /**
+         * Get flag registers of a chip.
+         *
+         * @param chip Chip index, 0 : bottom chip
+         * @return 3 flag registers
+         */
+        const byte *flags(const byte chip) const {return (&registers[chip * chipBytes + LTC6802::cfgRegisters + LTC6802::cellRegisters + LTC6802::tmpRegisters]);}
+       };
+
+      /**
+       * Queue counters.
+       */
+      struct Statistics
+       {
+        /**
+         * Scans pushed, including dropped ones.
+         */
+        unsigned long pushed;
+
+        /**
+         * Scans popped.
+         */
+        unsigned long popped;
+
+        /**
+         * Scans dropped by the overflow policy.
+         */
+        unsigned long dropped;
+       };
+
+      /**
+       * Constructor.
+       *
+       * @param numChips Number of chips of the stack
+       * @param capacity Scans the queue holds, 1 to 65533
+       * @param overflow Overflow policy
+       */
+      LTC6802ScanQueue(byte numChips, size_t capacity, Overflow overflow = dropOldest);
+
+      LTC6802ScanQueue(const LTC6802ScanQueue &) = delete;
+      LTC6802ScanQueue &operator=(const LTC6802ScanQueue &) = delete;
+
+      /**
+       * Queue the registers of a finished scan; producer thread.
+       *
+       * Copies the configuration, cell, temperature and flag registers of
+       * the stack and decodes cells and temperatures. Never blocks.
+       *
+       * @param stack Stack holding the scan
+       * @return true if queued, false if dropped
+       */
+      bool push(const LTC6802StackBase &stack);
+
+      /**
+       * Take the oldest queued scan; consumer thread.
+       *
+       * The record belongs to the consumer until the next pop().
+       *
+       * @return Record, nullptr if the queue is empty
+       */
+      const Record *pop();
+
+      /**
+       * Get number of queued scans.
+       *
+       * @return Scans, a snapshot when called while the other thread runs
+       */
+      size_t size() const;
+
+      /**
+       * Get capacity.
+       *
+       * @return Scans the queue holds
+       */
+      size_t getCapacity() const;
+
+      /**
+       * Get queue counters.
+       *
+       * @return Counters since construction
+       */
+      Statistics getStatistics() const;
+
+    private:
+      /**
+       * Number of chips.
+       */
+      const byte numChips;
+
+      /**
+       * Scans the queue holds.
+       */
+      const size_t capacity;
+
+      /**
+       * Overflow policy.
+       */
+      const Overflow overflow;
+
+      /**
+       * Records, one per slot plus the ones owned by producer and consumer.
+       */
+      std::vector<Record> records;
+
+      /**
+       * Ring slots: push index plus one above recordBits (0 : consumed), record number below.
+       */
+      std::vector<std::atomic<uint64_t>> slots;
+
+      /**
+       * Bits of the record number in a slot.
+       */
+      static const byte recordBits = 16;
+
+      /**
+       * Next scan to pop, advanced by the consumer only.
+       */
+      alignas(cacheLine) std::atomic<size_t> head {0};
+
+      /**
+       * Consumer copy of tail, reloaded only when the queue looks empty or a pop failed.
+       */
+      size_t tailCache = 0;
+
+      /**
+       * Record held by the consumer.
+       */
+      size_t current;
+
+      /**
+       * Scans popped.
+       */
+      std::atomic<unsigned long> popped {0};
+
+      /**
+       * Next scan to push, advanced by the producer only.
+       */
+      alignas(cacheLine) std::atomic<size_t> tail {0};
+
+      /**
+       * Producer copy of head, reloaded only when the queue looks full.
+       */
+      size_t headCache = 0;
+
+      /**
+       * Record the producer fills next.
+       */
+      size_t spare;
+
+      /**
+       * Scans pushed.
+       */
+      std::atomic<unsigned long> pushed {0};
+
+      /**
+       * Scans dropped.
+       */
+      std::atomic<unsigned long> dropped {0};
+
+      /**
+       * Build a slot value.
+       *
+       * @param tag Push index plus one, 0 : consumed
+       * @param record Record number
+       * @return Slot value
+       */
+      static uint64_t slot(size_t tag, size_t record);
+
+   };
+
+#endif
@@ -0,0 +1,222 @@
+/**
+ * Copyright 2017, 2019 Dipl.-Inform. Kai Hofmann
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <LTC6802SpidevTransport.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+
+LTC6802SpidevTransport::LTC6802SpidevTransport()
+ {
+  transfers.reserve(maxTransfers);
+  // Transfers point into the copies, so they must never move
+  copies.reserve(maxMessageBytes);
+ }
+
+
+LTC6802SpidevTransport::~LTC6802SpidevTransport()
+ {
+  close();
+ }
+
+
+bool LTC6802SpidevTransport::open(const char *const device, const unsigned long hz)
+ {
+  close();
+  fd = ::open(device, O_RDWR);
+  if (fd < 0)
+   {
+    return false;
+   }
+  uint8_t mode = SPI_MODE_3;
+  uint8_t bits = 8;
+  uint32_t speed = (uint32_t)hz;
+  if ((control(SPI_IOC_WR_MODE, &mode) < 0) || (control(SPI_IOC_WR_BITS_PER_WORD, &bits) < 0) || (control(SPI_IOC_WR_MAX_SPEED_HZ, &speed) < 0))
+   {
+    close();
+    return false;
+   }
+  clockHz = hz;
+  return true;
+ }
+
+
+void LTC6802SpidevTransport::close()
+ {
+  if (fd >= 0)
+   {
+    ::close(fd);
+    fd = -1;
+   }
+ }
+
+
+void LTC6802SpidevTransport::setBatching(const bool enable)
+ {
+  batches = enable;
+ }
+
+
+const LTC6802SpidevTransport::Statistics &LTC6802SpidevTransport::getStatistics() const
+ {
+  return statistics;
+ }
+
+
+void LTC6802SpidevTransport::resetStatistics()
+ {
+  statistics = Statistics();
+ }
+
+
+void LTC6802SpidevTransport::setClock(const unsigned long hz)
+ {
+  // Applied per transfer, no ioctl needed
+  clockHz = hz;
+ }
+
+
+unsigned long LTC6802SpidevTransport::getClock() const
+ {
+  return clockHz;
+ }
+
+
+void LTC6802SpidevTransport::attach(const byte csPin)
+ {
+  (void)csPin;
+ }
+
+
+void LTC6802SpidevTransport::select(const byte csPin)
+ {
+  (void)csPin;
+  selected = true;
+  ++statistics.frames;
+ }
+
+
+void LTC6802SpidevTransport::deselect(const byte csPin)
+ {
+  (void)csPin;
+  selected = false;
+  if (transfers.empty())
+   {
+    return;
+   }
+  // Ends the frame inside the message; on the last transfer of a message it would keep the chip selected
+  transfers.back().cs_change = 1;
+  if (!batching)
+   {
+    execute();
+   }
+ }
+
+
+byte LTC6802SpidevTransport::transfer(const byte data)
+ {
+  byte received;
+  append(&data, &received, 1);
+  execute();
+  return received;
+ }
+
+
+void LTC6802SpidevTransport::transfer(byte *const buf, const size_t len)
+ {
+  append(buf, buf, len);
+ }
+
+
+void LTC6802SpidevTransport::send(const byte *const buf, const size_t len)
+ {
+  append(buf, 0, len);
+ }
+
+
+bool LTC6802SpidevTransport::batchBegin()
+ {
+  batching = batches;
+  return batching;
+ }
+
+
+void LTC6802SpidevTransport::flush()
+ {
+  batching = false;
+  execute();
+ }
+
+
+int LTC6802SpidevTransport::control(const unsigned long request, void *const arg)
+ {
+  return ioctl(fd, request, arg);
+ }
+
+
+void LTC6802SpidevTransport::append(const byte *tx, byte *rx, size_t len)
+ {
+  while (len > 0)
+   {
+    if ((transfers.size() == maxTransfers) || (messageBytes == maxMessageBytes))
+     {
+      execute();
+     }
+    const size_t chunk = (len < maxMessageBytes - messageBytes) ? len : maxMessageBytes - messageBytes;
+    // Copy the sent bytes, callers may reuse their buffer before the message goes out
+    const size_t offset = copies.size();
+    copies.insert(copies.end(), tx, tx + chunk);
+    struct spi_ioc_transfer transfer;
+    memset(&transfer, 0, sizeof(transfer));
+    transfer.tx_buf = (uintptr_t)&copies[offset];
+    transfer.rx_buf = (uintptr_t)((rx != 0) ? rx : &copies[offset]);
+    transfer.len = (uint32_t)chunk;
+    transfer.speed_hz = (uint32_t)clockHz;
+    transfer.bits_per_word = 8;
+    transfers.push_back(transfer);
+    messageBytes += chunk;
+    tx += chunk;
+    rx = (rx != 0) ? rx + chunk : 0;
+    len -= chunk;
+   }
+ }
+
+
+void LTC6802SpidevTransport::execute()
+ {
+  if (transfers.empty())
+   {
+    return;
+   }
+  // A frame split over two messages keeps the chip selected in between
+  transfers.back().cs_change = selected ? 1 : 0;
+  ++statistics.ioctls;
+  statistics.transfers += transfers.size();
+  statistics.bytes += messageBytes;
+  if (control(SPI_IOC_MESSAGE(transfers.size()), transfers.data()) < 0)
+   {
+    // Reads like a released SDO line: no interrupt pending and register frames that fail the PEC check
+    ++statistics.errors;
+    for (const struct spi_ioc_transfer &transfer : transfers)
+     {
+      memset((void *)(uintptr_t)transfer.rx_buf, 0xff, transfer.len);
+     }
+   }
+  transfers.clear();
+  copies.clear();
+  messageBytes = 0;
+ }
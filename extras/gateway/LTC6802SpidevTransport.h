@@ -0,0 +1,215 @@
+/**
+ * Copyright 2017, 2019 Dipl.-Inform. Kai Hofmann
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef LTC6802SPIDEVTRANSPORT_H_INCLUDED_
+  #define LTC6802SPIDEVTRANSPORT_H_INCLUDED_
+
+  #include <LTC6802Transport.h>
+  #include <linux/spi/spidev.h>
+  #include <vector>
+
+  /**
+   * Transport for Linux userspace through a spidev device (/dev/spidevB.C).
+   *
+   * Every chip select frame becomes one spi_ioc_transfer; the frames are
+   * collected and handed to the kernel with one SPI_IOC_MESSAGE(n) ioctl,
+   * cs_change on the last transfer of a frame deselects the chip between
+   * frames. Outside a batch each frame is sent on deselect(), inside a batch
+   * (batchBegin(), used by the stack for every register group read and for
+   * scanRead()) all frames up to flush() go out together, so reading a whole
+   * stack costs one syscall instead of one per chip.
+   *
+   * The chip select is the one of the device node, the csPin arguments are
+   * ignored. Level polling (suspend()/resume()) is not supported.
+   *
+   * All ioctls go through control(), which the tests override with a fake
+   * backed by the chip simulator (LTC6802FakeSpidev).
+   */
+  class LTC6802SpidevTransport : public LTC6802Transport
+   {
+    public:
+      /**
+       * Most transfers in one message (SPI_MSGSIZE() limit of the ioctl).
+       */
+      static const size_t maxTransfers = ((1U << _IOC_SIZEBITS) - 1) / sizeof(struct spi_ioc_transfer);
+
+      /**
+       * Most bytes in one message (default bufsiz of the spidev driver).
+       */
+      static const size_t maxMessageBytes = 4096;
+
+      /**
+       * Syscall and traffic counters.
+       */
+      struct Statistics
+       {
+        /**
+         * SPI_IOC_MESSAGE ioctl calls (syscalls moving data).
+         */
+        unsigned long ioctls;
+
+        /**
+         * Chip select frames.
+         */
+        unsigned long frames;
+
+        /**
+         * spi_ioc_transfer entries.
+         */
+        unsigned long transfers;
+
+        /**
+         * Bytes clocked.
+         */
+        unsigned long bytes;
+
+        /**
+         * Failed ioctl calls, their received bytes read as 0xff.
+         */
+        unsigned long errors;
+       };
+
+      /**
+       * Constructor, see open().
+       */
+      LTC6802SpidevTransport();
+
+      /**
+       * Closes the device.
+       */
+      virtual ~LTC6802SpidevTransport();
+
+      LTC6802SpidevTransport(const LTC6802SpidevTransport &) = delete;
+      LTC6802SpidevTransport &operator=(const LTC6802SpidevTransport &) = delete;
+
+      /**
+       * Open a spidev device and set SPI mode 3, 8 bit words and the clock.
+       *
+       * @param device Device node, for example "/dev/spidev0.0"
+       * @param hz Clock rate in Hz
+       * @return true on success, errno tells the reason otherwise
+       */
+      bool open(const char *device, unsigned long hz = 1000000);
+
+      /**
+       * Close the device.
+       */
+      void close();
+
+      /**
+       * Send every frame on its own ioctl even inside a batch.
+       *
+       * For comparison, and for SPI controllers that ignore cs_change within a message.
+       *
+       * @param enable false : one ioctl per frame (default true)
+       */
+      void setBatching(bool enable);
+
+      /**
+       * Get syscall and traffic counters.
+       *
+       * @return Counters since construction or last reset
+       */
+      const Statistics &getStatistics() const;
+
+      /**
+       * Reset syscall and traffic counters.
+       */
+      void resetStatistics();
+
+      void setClock(unsigned long hz) override;
+      unsigned long getClock() const override;
+      void attach(byte csPin) override;
+      void select(byte csPin) override;
+      void deselect(byte csPin) override;
+      byte transfer(byte data) override;
+      void transfer(byte *buf, size_t len) override;
+      void send(const byte *buf, size_t len) override;
+      bool batchBegin() override;
+      void flush() override;
+
+    protected:
+      /**
+       * Issue one ioctl on the device.
+       *
+       * @param request ioctl request
+       * @param arg Request argument
+       * @return ioctl result, -1 on error
+       */
+      virtual int control(unsigned long request, void *arg);
+
+    private:
+      /**
+       * Device file descriptor, -1 : closed.
+       */
+      int fd = -1;
+
+      /**
+       * Clock rate in Hz.
+       */
+      unsigned long clockHz = 1000000;
+
+      /**
+       * Collect frames across deselect() until flush().
+       */
+      bool batching = false;
+
+      /**
+       * Batches enabled.
+       */
+      bool batches = true;
+
+      /**
+       * Chip is selected.
+       */
+      bool selected = false;
+
+      /**
+       * Transfers of the pending message.
+       */
+      std::vector<struct spi_ioc_transfer> transfers;
+
+      /**
+       * Bytes of the pending message.
+       */
+      size_t messageBytes = 0;
+
+      /**
+       * Copies of the bytes given to send() and transfer(byte).
+       */
+      std::vector<byte> copies;
+
+      /**
+       * Syscall and traffic counters.
+       */
+      Statistics statistics = Statistics();
+
+      /**
+       * Append a transfer to the pending message, sending it first if full.
+       *
+       * @param tx Bytes to send
+       * @param rx Buffer for the received bytes, 0 : discard
+       * @param len Number of bytes
+       */
+      void append(const byte *tx, byte *rx, size_t len);
+
+      /**
+       * Send the pending message with one ioctl.
+       */
+      void execute();
+
+   };
+
+#endif
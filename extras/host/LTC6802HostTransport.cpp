@@ -0,0 +1,335 @@
+/**
+ * Copyright 2017, 2019 Dipl.-Inform. Kai Hofmann
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <LTC6802HostTransport.h>
+#include <LTC6802.h>
+#include <LTC6802Registers.h>
+#include <LTC6802PEC.h>
+
+
+LTC6802HostTransport::LTC6802HostTransport(LTC6802Simulator *const *const chips, const byte numChips, const Topology topology)
+ : chips(chips, chips + numChips), topology(topology)
+ {
+ }
+
+
+void LTC6802HostTransport::setClock(const unsigned long hz)
+ {
+  clockHz = hz;
+ }
+
+
+unsigned long LTC6802HostTransport::getClock() const
+ {
+  return clockHz;
+ }
+
+
+void LTC6802HostTransport::setClockLimit(const unsigned long hz, const double probability)
+ {
+  clockLimit = hz;
+  limitThreshold = (uint32_t)(probability * 4294967295.0);
+ }
+
+
+void LTC6802HostTransport::setOverheads(const unsigned long selectNanos, const unsigned long callNanos)
+ {
+  this->selectNanos = selectNanos;
+  this->callNanos = callNanos;
+ }
+
+
+void LTC6802HostTransport::setErrorRate(const double probability)
+ {
+  errorThreshold = (uint32_t)(probability * 4294967295.0);
+ }
+
+
+const LTC6802HostTransport::Statistics &LTC6802HostTransport::getStatistics() const
+ {
+  return statistics;
+ }
+
+
+void LTC6802HostTransport::resetStatistics()
+ {
+  statistics = Statistics{0, 0, 0, 0, 0, 0};
+ }
+
+
+void LTC6802HostTransport::setEdgeHandler(void (*const handler)(void *context), void *const context)
+ {
+  edgeHandler = handler;
+  edgeContext = context;
+ }
+
+
+bool LTC6802HostTransport::getSdo() const
+ {
+  return !selected || !((response == pollADC) || (response == pollINT)) || pollLevel();
+ }
+
+
+bool LTC6802HostTransport::injectEdges()
+ {
+  const bool level = getSdo();
+  const bool rising = level && !sdoLevel;
+  sdoLevel = level;
+  if (rising && (edgeHandler != 0))
+   {
+    edgeHandler(edgeContext);
+    // Traffic of the handler is not seen as edges, like an interrupt flag cleared on return
+    sdoLevel = getSdo();
+   }
+  return rising;
+ }
+
+
+void LTC6802HostTransport::attach(byte)
+ {
+ }
+
+
+void LTC6802HostTransport::select(byte)
+ {
+  LTC6802HostClock::advance(selectNanos);
+  statistics.busNanos += selectNanos;
+  ++statistics.frames;
+  for (LTC6802Simulator *const chip : chips)
+   {
+    chip->touch();
+   }
+  selected = true;
+  position = 0;
+  target = -1;
+  response = idle;
+  output.clear();
+  input.clear();
+ }
+
+
+void LTC6802HostTransport::deselect(byte)
+ {
+  if (response == writing)
+   {
+    commitWrite();
+   }
+  response = idle;
+  selected = false;
+ }
+
+
+byte LTC6802HostTransport::transfer(const byte data)
+ {
+  clockBytes(1);
+  return corrupt(exchange(data));
+ }
+
+
+void LTC6802HostTransport::transfer(byte *const buf, const size_t len)
+ {
+  clockBytes(len);
+  for (size_t i = 0; i < len; ++i)
+   {
+    buf[i] = corrupt(exchange(buf[i]));
+   }
+ }
+
+
+byte LTC6802HostTransport::corrupt(const byte data)
+ {
+  const uint32_t threshold = ((clockLimit != 0) && (clockHz > clockLimit)) ? limitThreshold : errorThreshold;
+  if (threshold == 0)
+   {
+    return data;
+   }
+  random ^= random << 13;
+  random ^= random >> 17;
+  random ^= random << 5;
+  if (random >= threshold)
+   {
+    return data;
+   }
+  ++statistics.corrupted;
+  return data ^ (byte)(1 << (random & 0x07));
+ }
+
+
+void LTC6802HostTransport::clockBytes(const unsigned long len)
+ {
+  const uint64_t nanos = callNanos + (uint64_t)len * 8 * 1000000000UL / clockHz;
+  LTC6802HostClock::advance(nanos);
+  statistics.busNanos += nanos;
+  statistics.bytes += len;
+  ++statistics.calls;
+ }
+
+
+byte LTC6802HostTransport::exchange(const byte data)
+ {
+  const unsigned long pos = position++;
+  if (pos == 0)
+   {
+    if ((topology == addressed) && ((data & 0xf0) == 0x80))
+     {
+      target = -2;
+      for (unsigned int i = 0; i < chips.size(); ++i)
+       {
+        if (chips[i]->getAddress() == data)
+         {
+          target = i;
+         }
+       }
+     }
+    else
+     {
+      dispatch(data);
+     }
+    return 0xff;
+   }
+  if ((pos == 1) && (topology == addressed) && (target != -1))
+   {
+    dispatch(data);
+    return 0xff;
+   }
+  switch (response)
+   {
+    case readback:
+     {
+      const unsigned long index = pos - ((target == -1) ? 1 : 2);
+      return (index < output.size()) ? output[index] : 0xff;
+     }
+    case pollADC:
+      // Toggle polling (LVLPL clear): a finished conversion toggles SDO at 1kHz instead of holding it high
+      if (pollLevel() && pollToggles())
+       {
+        return ((micros() / 500) & 1) ? 0x00 : 0xff;
+       }
+      return pollLevel() ? 0xff : 0x00;
+    case pollINT:
+      return pollLevel() ? 0xff : 0x00;
+    case writing:
+      input.push_back(data);
+      return 0xff;
+    default:
+      return 0xff;
+   }
+ }
+
+
+void LTC6802HostTransport::dispatch(const byte cmd)
+ {
+  switch (cmd)
+   {
+    case RDCFG:
+    case RDCV:
+    case RDFLG:
+    case RDTMP:
+      response = readback;
+      for (unsigned int i = 0; i < chips.size(); ++i)
+       {
+        // Broadcast reads are only defined for the daisy chain
+        if ((topology == daisyChain) || ((target >= 0) && ((int)i == target)))
+         {
+          byte group[LTC6802::cellRegisters + 1];
+          const byte len = chips[i]->readGroup(cmd, group);
+          output.insert(output.end(), group, group + len);
+         }
+       }
+      break;
+    case WRCFG:
+      response = writing;
+      break;
+    case PLADC:
+      response = pollADC;
+      break;
+    case PLINT:
+      response = pollINT;
+      break;
+    default:
+      for (unsigned int i = 0; i < chips.size(); ++i)
+       {
+        if (targets(i))
+         {
+          chips[i]->command(cmd);
+         }
+       }
+      response = pollADC;
+      break;
+   }
+ }
+
+
+bool LTC6802HostTransport::targets(const int chip) const
+ {
+  return (target == -1) || (target == chip);
+ }
+
+
+bool LTC6802HostTransport::pollLevel() const
+ {
+  for (unsigned int i = 0; i < chips.size(); ++i)
+   {
+    if (targets(i) && ((response == pollADC) ? chips[i]->isBusy() : chips[i]->hasInterrupt()))
+     {
+      return false;
+     }
+   }
+  return true;
+ }
+
+
+bool LTC6802HostTransport::pollToggles() const
+ {
+  for (unsigned int i = 0; i < chips.size(); ++i)
+   {
+    if (targets(i) && ((chips[i]->getConfig()[0] & CFG0_LVLPL_MSK) == 0))
+     {
+      return true;
+     }
+   }
+  return false;
+ }
+
+
+void LTC6802HostTransport::commitWrite()
+ {
+  const unsigned int cfgLen = LTC6802::cfgRegisters;
+  if (topology == daisyChain)
+   {
+    // First configuration shifted in ends up in the top chip
+    for (unsigned int block = 0; (block < chips.size()) && ((block + 1) * cfgLen <= input.size()); ++block)
+     {
+      chips[chips.size() - 1 - block]->writeConfig(&input[block * cfgLen]);
+     }
+    return;
+   }
+  if (input.size() < cfgLen)
+   {
+    return;
+   }
+  if ((input.size() > cfgLen) && !LTC6802PEC::check(&input[0], cfgLen))
+   {
+    ++statistics.rejectedWrites;
+    return;
+   }
+  for (unsigned int i = 0; i < chips.size(); ++i)
+   {
+    if (targets(i))
+     {
+      chips[i]->writeConfig(&input[0]);
+     }
+   }
+ }
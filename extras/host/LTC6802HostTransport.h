@@ -0,0 +1,339 @@
+/**
+ * Copyright 2017, 2019 Dipl.-Inform. Kai Hofmann
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef LTC6802HOSTTRANSPORT_H_INCLUDED_
+  #define LTC6802HOSTTRANSPORT_H_INCLUDED_
+
+  #include <LTC6802Transport.h>
+  #include <LTC6802Simulator.h>
+  #include <vector>
+
+  /**
+   * Host transport connecting the driver to simulated LTC6802 chips.
+   *
+   * Implements the wire protocol of the LTC6802-2 (addressed, open drain SDO)
+   * and the LTC6802-1 (daisy chain) on top of LTC6802Simulator chip models,
+   * advances the virtual host clock by the modeled bus time and counts
+   * bus traffic.
+   */
+  class LTC6802HostTransport : public LTC6802Transport
+   {
+    public:
+      /**
+       * Bus topology.
+       */
+      enum Topology
+       {
+        /**
+         * LTC6802-2: every frame starts with an address byte or is a broadcast.
+         */
+        addressed,
+
+        /**
+         * LTC6802-1: all chips share one frame, data is shifted through the chain.
+         */
+        daisyChain
+       };
+
+      /**
+       * Bus traffic counters.
+       */
+      struct Statistics
+       {
+        /**
+         * Chip select assertions.
+         */
+        unsigned long frames;
+
+        /**
+         * Bytes clocked.
+         */
+        unsigned long bytes;
+
+        /**
+         * Transfer calls.
+         */
+        unsigned long calls;
+
+        /**
+         * Modeled bus time in nanoseconds.
+         */
+        uint64_t busNanos;
+
+        /**
+         * Received bytes corrupted by error injection.
+         */
+        unsigned long corrupted;
+
+        /**
+         * Configuration writes rejected because of a PEC mismatch.
+         */
+        unsigned long rejectedWrites;
+       };
+
+      /**
+       * Constructor.
+       *
+       * @param chips Simulated chips, bottom of the chain first
+       * @param numChips Number of chips
+       * @param topology Bus topology
+       */
+      LTC6802HostTransport(LTC6802Simulator *const *chips, byte numChips, Topology topology = addressed);
+
+      /**
+       * Set modeled SPI clock.
+       *
+       * @param hz Clock rate in Hz (default 1MHz)
+       */
+      void setClock(unsigned long hz) override;
+
+      /**
+       * Get modeled SPI clock.
+       *
+       * @return Clock rate in Hz
+       */
+      unsigned long getClock() const override;
+
+      /**
+       * Model the signal integrity of the wiring.
+       *
+       * @param hz Highest clock rate the wiring transfers reliably (0 : unlimited)
+       * @param probability Probability per byte to flip one bit above that rate
+       */
+      void setClockLimit(unsigned long hz, double probability = 0.05);
+
+      /**
+       * Set modeled software overheads.
+       *
+       * @param selectNanos Time per chip select assertion (default 2us)
+       * @param callNanos Time per transfer call (default 1us)
+       */
+      void setOverheads(unsigned long selectNanos, unsigned long callNanos);
+
+      /**
+       * Inject bit errors into received bytes.
+       *
+       * @param probability Probability per byte to flip one bit (0 : off)
+       */
+      void setErrorRate(double probability);
+
+      /**
+       * Get bus traffic counters.
+       *
+       * @return Counters since construction or last reset
+       */
+      const Statistics &getStatistics() const;
+
+      /**
+       * Reset bus traffic counters.
+       */
+      void resetStatistics();
+
+      /**
+       * Set the handler of rising SDO edges, the pin change interrupt of the MCU.
+       *
+       * @param handler Called with context on every delivered edge, 0 : none
+       * @param context Passed to the handler
+       */
+      void setEdgeHandler(void (*handler)(void *context), void *context);
+
+      /**
+       * Get SDO level.
+       *
+       * With chip select low after PLADC/PLINT the chips drive the poll
+       * result (level polling), otherwise SDO reads high.
+       *
+       * @return true : high
+       */
+      bool getSdo() const;
+
+      /**
+       * Deliver a rising SDO edge since the last call to the edge handler.
+       *
+       * Host loops call this where the MCU would take the pin change interrupt,
+       * e.g. after every delay.
+       *
+       * @return true if an edge was delivered
+       */
+      bool injectEdges();
+
+      void attach(byte csPin) override;
+      void select(byte csPin) override;
+      void deselect(byte csPin) override;
+      byte transfer(byte data) override;
+      void transfer(byte *buf, size_t len) override;
+
+    protected:
+      /**
+       * Advance virtual time and counters for clocked bytes.
+       *
+       * @param len Number of bytes clocked in one call
+       */
+      void clockBytes(unsigned long len);
+
+      /**
+       * Run one byte through the protocol model without timing.
+       *
+       * @param data Byte sent
+       * @return Byte received
+       */
+      byte exchange(byte data);
+
+      /**
+       * Apply error injection to a received byte.
+       *
+       * @param data Byte received
+       * @return Byte as seen by the MCU
+       */
+      byte corrupt(byte data);
+
+    private:
+      /**
+       * What the chips drive on SDO after the command byte.
+       */
+      enum Response {idle, readback, pollADC, pollINT, writing};
+
+      /**
+       * Simulated chips.
+       */
+      std::vector<LTC6802Simulator *> chips;
+
+      /**
+       * Bus topology.
+       */
+      Topology topology;
+
+      /**
+       * SPI clock in Hz.
+       */
+      unsigned long clockHz = 1000000;
+
+      /**
+       * Time per chip select assertion.
+       */
+      unsigned long selectNanos = 2000;
+
+      /**
+       * Time per transfer call.
+       */
+      unsigned long callNanos = 1000;
+
+      /**
+       * Bus traffic counters.
+       */
+      Statistics statistics = {0, 0, 0, 0, 0, 0};
+
+      /**
+       * Error injection threshold, probability scaled to 2^32.
+       */
+      uint32_t errorThreshold = 0;
+
+      /**
+       * Highest reliable clock rate, 0 : unlimited.
+       */
+      unsigned long clockLimit = 0;
+
+      /**
+       * Error injection threshold above the clock limit, probability scaled to 2^32.
+       */
+      uint32_t limitThreshold = 0;
+
+      /**
+       * Error injection random state (xorshift32).
+       */
+      uint32_t random = 0x2545f491;
+
+      /**
+       * Byte position in current frame.
+       */
+      unsigned long position = 0;
+
+      /**
+       * Addressed chip (-1 : broadcast, -2 : unknown address).
+       */
+      int target = -1;
+
+      /**
+       * SDO response mode of current frame.
+       */
+      Response response = idle;
+
+      /**
+       * Chip select is low.
+       */
+      bool selected = false;
+
+      /**
+       * SDO level seen by the last injectEdges().
+       */
+      bool sdoLevel = true;
+
+      /**
+       * Handler of rising SDO edges.
+       */
+      void (*edgeHandler)(void *context) = 0;
+
+      /**
+       * Context passed to the edge handler.
+       */
+      void *edgeContext = 0;
+
+      /**
+       * Bytes to shift out.
+       */
+      std::vector<byte> output;
+
+      /**
+       * Bytes shifted in after a write command.
+       */
+      std::vector<byte> input;
+
+      /**
+       * Handle a command byte.
+       *
+       * @param cmd Command
+       */
+      void dispatch(byte cmd);
+
+      /**
+       * Check whether chip is targeted by current frame.
+       *
+       * @param chip Chip index
+       * @return true if chip handles the frame
+       */
+      bool targets(int chip) const;
+
+      /**
+       * Get the level the chips drive for a poll command.
+       *
+       * @return true : high (no conversion running / no interrupt pending)
+       */
+      bool pollLevel() const;
+
+      /**
+       * Check whether a finished conversion toggles SDO.
+       *
+       * @return true if a targeted chip uses toggle polling (LVLPL clear)
+       */
+      bool pollToggles() const;
+
+      /**
+       * Apply collected configuration write.
+       */
+      void commitWrite();
+
+   };
+
+#endif
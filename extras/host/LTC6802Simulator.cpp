@@ -0,0 +1,373 @@
+/**
+ * Copyright 2017, 2019 Dipl.-Inform. Kai Hofmann
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <LTC6802Simulator.h>
+#include <LTC6802Registers.h>
+#include <string.h>
+
+
+byte LTC6802Simulator::pec(const byte *const data, const byte len)
+ {
+  byte crc = 0x41;
+  for (int i = 0; i < len; ++i)
+   {
+    crc ^= data[i];
+    for (int bit = 0; bit < 8; ++bit)
+     {
+      crc = (crc & 0x80) ? ((crc << 1) ^ 0x07) : (crc << 1);
+     }
+   }
+  return crc;
+ }
+
+
+LTC6802Simulator::LTC6802Simulator(const byte address)
+ : address(address)
+ {
+  for (int i = 0; i < 12; ++i)
+   {
+    cellInputs[i] = 2400; // 3.6V
+    sampled[i] = 0;
+   }
+  tmpInputs[0] = 1000;
+  tmpInputs[1] = 1000;
+  setInternalTemperature(25);
+  memset(CV, 0, sizeof(CV));
+  memset(TMP, 0, sizeof(TMP));
+  memset(FLG, 0, sizeof(FLG));
+  resetConfig();
+ }
+
+
+byte LTC6802Simulator::getAddress() const
+ {
+  return address;
+ }
+
+
+void LTC6802Simulator::setCellVoltage(const byte cell, const word millivolts)
+ {
+  setCellCode(cell, (word)((millivolts * 2UL + 1) / 3));
+ }
+
+
+void LTC6802Simulator::setCellCode(const byte cell, const word code)
+ {
+  cellInputs[cell] = code & 0x0fff;
+ }
+
+
+void LTC6802Simulator::setExternalTemperatureCode(const byte input, const word code)
+ {
+  tmpInputs[input] = code & 0x0fff;
+ }
+
+
+void LTC6802Simulator::setInternalTemperature(const int celsius)
+ {
+  // itmp * 1.5mV / 8mV per Kelvin
+  tmpInputs[2] = (word)(((long)celsius + 273) * 16 / 3);
+ }
+
+
+void LTC6802Simulator::setThermalShutdown(const bool thsd)
+ {
+  this->thsd = thsd;
+ }
+
+
+void LTC6802Simulator::setOpenWire(const byte input, const bool open)
+ {
+  if (open)
+   {
+    openWires |= 1 << input;
+   }
+  else
+   {
+    openWires &= ~(1 << input);
+   }
+ }
+
+
+void LTC6802Simulator::setSelfTestFault(const word mask)
+ {
+  selfTestFault = mask & 0x0fff;
+ }
+
+
+const byte *LTC6802Simulator::getConfig() const
+ {
+  return CFG;
+ }
+
+
+unsigned long LTC6802Simulator::getConversions() const
+ {
+  return conversions;
+ }
+
+
+void LTC6802Simulator::touch()
+ {
+  const uint64_t now = LTC6802HostClock::nanos();
+  if ((now - lastActivity) > (uint64_t)watchdogMicros * 1000)
+   {
+    resetConfig();
+   }
+  lastActivity = now;
+ }
+
+
+void LTC6802Simulator::command(const byte cmd)
+ {
+  update();
+  const byte type = cmd & 0xf0;
+  byte chn = cmd & 0x0f;
+  unsigned long channels = 0;
+  if ((type == STCVAD) || (type == STCDC) || (type == STOWAD) || (type == STOWDC))
+   {
+    converting = cells;
+    channels = (chn == 0) ? ((CFG[0] & CFG0_CELL10_MSK) ? 10 : 12) : 1;
+    memcpy(sampled, cellInputs, sizeof(sampled));
+    if ((type == STOWAD) || (type == STOWDC))
+     {
+      // The 100uA pull down discharges an open input: the cell below reads 0, the cell above both
+      for (int input = 1; input <= 12; ++input)
+       {
+        if ((openWires & (1 << input)) == 0)
+         {
+          continue;
+         }
+        if (input < 12)
+         {
+          const word both = sampled[input - 1] + sampled[input];
+          sampled[input] = (both > 0x0fff) ? 0x0fff : both;
+         }
+        sampled[input - 1] = 0;
+       }
+     }
+   }
+  else if (type == STTMPAD)
+   {
+    converting = temperatures;
+    channels = (chn == 0) ? 3 : 1;
+    memcpy(sampled, tmpInputs, sizeof(tmpInputs));
+   }
+  else
+   {
+    return;
+   }
+  selfTest = (chn >= 0x0e);
+  if (selfTest)
+   {
+    // Self test converts all channels of the group to a fixed pattern
+    const word pattern = ((chn == 0x0e) ? 0x0555 : 0x0aaa) ^ selfTestFault;
+    for (int i = 0; i < 12; ++i)
+     {
+      sampled[i] = pattern;
+     }
+    channels = (type == STTMPAD) ? 3 : 12;
+    chn = 0;
+   }
+  channel = chn;
+  readyAt = LTC6802HostClock::nanos() + (uint64_t)channels * channelConversionMicros * 1000;
+  ++conversions;
+ }
+
+
+bool LTC6802Simulator::isBusy()
+ {
+  update();
+  return (converting != none);
+ }
+
+
+bool LTC6802Simulator::hasInterrupt()
+ {
+  update();
+  return ((FLG[0] | FLG[1] | FLG[2]) != 0);
+ }
+
+
+byte LTC6802Simulator::readGroup(const byte cmd, byte *const arr)
+ {
+  update();
+  const byte *group;
+  byte len;
+  bool invalid = false;
+  switch (cmd)
+   {
+    case RDCFG:
+      group = CFG;
+      len = sizeof(CFG);
+      break;
+    case RDCV:
+      group = CV;
+      len = sizeof(CV);
+      invalid = (converting == cells);
+      break;
+    case RDFLG:
+      group = FLG;
+      len = sizeof(FLG);
+      invalid = (converting == cells);
+      break;
+    case RDTMP:
+      group = TMP;
+      len = sizeof(TMP);
+      invalid = (converting == temperatures);
+      break;
+    default:
+      return 0;
+   }
+  if (invalid)
+   {
+    memset(arr, 0xff, len);
+   }
+  else
+   {
+    memcpy(arr, group, len);
+   }
+  arr[len] = pec(arr, len);
+  return len + 1;
+ }
+
+
+void LTC6802Simulator::writeConfig(const byte *const cfg)
+ {
+  // WDT is read only and high as long as the watchdog did not expire
+  CFG[0] = CFG0_WDT_MSK | (cfg[0] & CFG0_WDT_INVMSK);
+  for (int i = 1; i < 6; ++i)
+   {
+    CFG[i] = cfg[i];
+   }
+ }
+
+
+void LTC6802Simulator::update()
+ {
+  if ((converting != none) && (LTC6802HostClock::nanos() >= readyAt))
+   {
+    if (converting == cells)
+     {
+      finishCells();
+     }
+    else
+     {
+      finishTemperatures();
+     }
+    converting = none;
+   }
+  if (converting == none)
+   {
+    monitor();
+   }
+ }
+
+
+void LTC6802Simulator::finishCells()
+ {
+  const byte cellCount = (CFG[0] & CFG0_CELL10_MSK) ? 10 : 12;
+  for (int i = 0; i < 12; ++i)
+   {
+    if (((channel != 0) && (channel != i + 1)) || (i >= cellCount))
+     {
+      continue;
+     }
+    const word code = sampled[i];
+    byte *const reg = &CV[(i / 2) * 3];
+    if ((i & 1) == 0)
+     {
+      reg[0] = code & 0xff;
+      reg[1] = (reg[1] & 0xf0) | (code >> 8);
+     }
+    else
+     {
+      reg[1] = (reg[1] & 0x0f) | ((code & 0x0f) << 4);
+      reg[2] = code >> 4;
+     }
+    if (!selfTest)
+     {
+      compare(i, code);
+     }
+   }
+ }
+
+
+void LTC6802Simulator::compare(const byte cell, const word code)
+ {
+  const word mci = (CFG[3] << 4) | ((CFG[2] & CFG2_MCI_MSK) >> 4);
+  const word vuv = CFG[4] * 16;
+  const word vov = CFG[5] * 16;
+  const bool uv = (vuv != 0) && (code < vuv) && !(mci & (1 << cell));
+  const bool ov = (vov != 0) && (code > vov) && !(mci & (1 << cell));
+  const byte flags = (uv ? 0x01 : 0x00) | (ov ? 0x02 : 0x00);
+  const byte shift = (cell % 4) * 2;
+  FLG[cell / 4] = (FLG[cell / 4] & ~(0x03 << shift)) | (flags << shift);
+ }
+
+
+void LTC6802Simulator::monitor()
+ {
+  // Comparator period of CDC 2-7 in ms
+  static const unsigned long periods[6] = {13, 130, 500, 130, 500, 2000};
+  const uint64_t now = LTC6802HostClock::nanos();
+  const byte cdc = CFG[0] & CFG0_CDC_MSK;
+  if (cdc < 2)
+   {
+    lastCompare = now;
+    return;
+   }
+  if ((now - lastCompare) < (uint64_t)periods[cdc - 2] * 1000000)
+   {
+    return;
+   }
+  lastCompare = now;
+  const byte cellCount = (CFG[0] & CFG0_CELL10_MSK) ? 10 : 12;
+  for (byte cell = 0; cell < cellCount; ++cell)
+   {
+    compare(cell, cellInputs[cell]);
+   }
+ }
+
+
+void LTC6802Simulator::finishTemperatures()
+ {
+  if ((channel == 0) || (channel == 1))
+   {
+    TMP[0] = sampled[0] & 0xff;
+    TMP[1] = (TMP[1] & 0xf0) | (sampled[0] >> 8);
+   }
+  if ((channel == 0) || (channel == 2))
+   {
+    TMP[1] = (TMP[1] & 0x0f) | ((sampled[1] & 0x0f) << 4);
+    TMP[2] = sampled[1] >> 4;
+   }
+  if ((channel == 0) || (channel == 3))
+   {
+    TMP[3] = sampled[2] & 0xff;
+    TMP[4] = (thsd ? 0x10 : 0x00) | (sampled[2] >> 8); // REV 0
+   }
+ }
+
+
+void LTC6802Simulator::resetConfig()
+ {
+  // GPIO pull downs off, standby, comparator thresholds cleared
+  CFG[0] = CFG0_GPIO2_MSK | CFG0_GPIO1_MSK;
+  for (int i = 1; i < 6; ++i)
+   {
+    CFG[i] = 0;
+   }
+ }
@@ -0,0 +1,313 @@
+/**
+ * Copyright 2017, 2019 Dipl.-Inform. Kai Hofmann
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef LTC6802SIMULATOR_H_INCLUDED_
+  #define LTC6802SIMULATOR_H_INCLUDED_
+
+  #include <LTC6802Platform.h>
+
+  /**
+   * Software model of one LTC6802 chip for host builds.
+   *
+   * Models the register groups, the conversion timing of STCVAD/STOWAD/STTMPAD,
+   * open cell input connections, the A/D self tests,
+   * the overvoltage/undervoltage comparator flags including the periodic
+   * comparator measurements of CDC 2-7, the watchdog
+   * configuration reset and the packet error code of read responses.
+   * Wire protocol (addressing, daisy chain) is handled by the host transport.
+   */
+  class LTC6802Simulator
+   {
+    public:
+      /**
+       * Conversion time of one A/D channel (12 cells take 12.8ms).
+       */
+      static const unsigned long channelConversionMicros = 1066;
+
+      /**
+       * Watchdog timeout without SPI activity.
+       */
+      static const unsigned long watchdogMicros = 2500000;
+
+      /**
+       * Calculate packet error code (CRC-8, x^8 + x^2 + x + 1, init 0x41).
+       *
+       * Bitwise reference implementation, independent of the driver code.
+       *
+       * @param data Bytes
+       * @param len Number of bytes
+       * @return Packet error code
+       */
+      static byte pec(const byte *data, byte len);
+
+      /**
+       * Constructor.
+       *
+       * @param address Chip address byte (0x80 | address pins)
+       */
+      explicit LTC6802Simulator(byte address);
+
+      /**
+       * Get chip address byte.
+       *
+       * @return Address byte
+       */
+      byte getAddress() const;
+
+      /**
+       * Set cell input voltage.
+       *
+       * @param cell Cell index 0-11
+       * @param millivolts Cell voltage in mV
+       */
+      void setCellVoltage(byte cell, word millivolts);
+
+      /**
+       * Set raw cell A/D code (1.5mV per count).
+       *
+       * @param cell Cell index 0-11
+       * @param code 12 bit A/D code
+       */
+      void setCellCode(byte cell, word code);
+
+      /**
+       * Set raw external temperature A/D code (1.5mV per count).
+       *
+       * @param input 0 : ETMP1; 1 : ETMP2
+       * @param code 12 bit A/D code
+       */
+      void setExternalTemperatureCode(byte input, word code);
+
+      /**
+       * Set die temperature.
+       *
+       * @param celsius Temperature in degree celsius
+       */
+      void setInternalTemperature(int celsius);
+
+      /**
+       * Set thermal shutdown status bit.
+       *
+       * @param thsd Thermal shutdown occurred
+       */
+      void setThermalShutdown(bool thsd);
+
+      /**
+       * Break or restore the connection of a cell input.
+       *
+       * Normal conversions still read the held voltages, open-wire
+       * conversions pull the open input down: the cell below reads 0 and
+       * the cell above reads both cells.
+       *
+       * @param input Cell input 1-12 (C1-C12)
+       * @param open true : connection broken
+       */
+      void setOpenWire(byte input, bool open);
+
+      /**
+       * Inject an A/D fault visible in self test results.
+       *
+       * @param mask Bits flipped in self test codes, 0 : healthy
+       */
+      void setSelfTestFault(word mask);
+
+      /**
+       * Get configuration register group as last written.
+       *
+       * @return 6 configuration registers
+       */
+      const byte *getConfig() const;
+
+      /**
+       * Get number of started conversions.
+       *
+       * @return Conversion counter
+       */
+      unsigned long getConversions() const;
+
+      /**
+       * Register SPI activity (restarts the watchdog).
+       */
+      void touch();
+
+      /**
+       * Execute a non read/write command (conversion start, poll).
+       *
+       * @param cmd Command byte
+       */
+      void command(byte cmd);
+
+      /**
+       * Check for running conversion.
+       *
+       * @return true while the A/D converter is busy
+       */
+      bool isBusy();
+
+      /**
+       * Check for pending comparator interrupt.
+       *
+       * @return true if an unmasked overvoltage/undervoltage flag is set
+       */
+      bool hasInterrupt();
+
+      /**
+       * Read a register group followed by its packet error code.
+       *
+       * @param cmd Read command
+       * @param arr Array for at least 19 bytes
+       * @return Number of bytes including PEC, 0 if cmd is no read command
+       */
+      byte readGroup(byte cmd, byte *arr);
+
+      /**
+       * Write configuration register group.
+       *
+       * @param cfg 6 configuration registers
+       */
+      void writeConfig(const byte *cfg);
+
+    private:
+      /**
+       * Type of running conversion.
+       */
+      enum Conversion {none, cells, temperatures};
+
+      /**
+       * Chip address byte.
+       */
+      byte address;
+
+      /**
+       * Cell input A/D codes.
+       */
+      word cellInputs[12];
+
+      /**
+       * Temperature input A/D codes: ETMP1, ETMP2, ITMP.
+       */
+      word tmpInputs[3];
+
+      /**
+       * Broken cell input connections, bit n : input Cn.
+       */
+      word openWires = 0;
+
+      /**
+       * Bits flipped in self test codes.
+       */
+      word selfTestFault = 0;
+
+      /**
+       * Thermal shutdown status.
+       */
+      bool thsd = false;
+
+      /**
+       * Configuration register group.
+       */
+      byte CFG[6];
+
+      /**
+       * Cell voltage register group.
+       */
+      byte CV[18];
+
+      /**
+       * Temperature register group.
+       */
+      byte TMP[5];
+
+      /**
+       * Flag register group.
+       */
+      byte FLG[3];
+
+      /**
+       * Running conversion.
+       */
+      Conversion converting = none;
+
+      /**
+       * Channel of the running conversion (0 : all).
+       */
+      byte channel = 0;
+
+      /**
+       * Running conversion is a self test.
+       */
+      bool selfTest = false;
+
+      /**
+       * Inputs sampled at conversion start.
+       */
+      word sampled[12];
+
+      /**
+       * Virtual time the running conversion completes.
+       */
+      uint64_t readyAt = 0;
+
+      /**
+       * Virtual time of the last periodic comparator measurement.
+       */
+      uint64_t lastCompare = 0;
+
+      /**
+       * Virtual time of last SPI activity.
+       */
+      uint64_t lastActivity = 0;
+
+      /**
+       * Started conversions.
+       */
+      unsigned long conversions = 0;
+
+      /**
+       * Finish a running conversion if its time is over.
+       */
+      void update();
+
+      /**
+       * Store cell results and comparator flags.
+       */
+      void finishCells();
+
+      /**
+       * Update the comparator flags of a cell.
+       *
+       * @param cell Cell index 0-11
+       * @param code A/D code of the cell
+       */
+      void compare(byte cell, word code);
+
+      /**
+       * Run the periodic comparator measurement of CDC 2-7 when due.
+       */
+      void monitor();
+
+      /**
+       * Store temperature results.
+       */
+      void finishTemperatures();
+
+      /**
+       * Reset configuration to power on defaults.
+       */
+      void resetConfig();
+
+   };
+
+#endif
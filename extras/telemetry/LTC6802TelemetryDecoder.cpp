@@ -0,0 +1,246 @@
+/**
+ * Copyright 2017, 2019 Dipl.-Inform. Kai Hofmann
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <LTC6802TelemetryDecoder.h>
+#include <string.h>
+
+
+/**
+ * Read a 16 bit value little endian.
+ *
+ * @param buf Buffer position
+ * @return Value
+ */
+static uint16_t get16(const byte *const buf)
+ {
+  return (uint16_t)(buf[0] | (buf[1] << 8));
+ }
+
+
+bool LTC6802TelemetryDecoder::decode(const byte *const data, const size_t len, Frame &frame, bool &crcError)
+ {
+  crcError = false;
+  byte payload[LTC6802Telemetry::maxPayloadBytes];
+  size_t size = 0;
+  size_t pos = 0;
+  while (pos < len)
+   {
+    const byte code = data[pos++];
+    if ((code == 0) || (pos + code - 1 > len))
+     {
+      return false;
+     }
+    for (byte i = 1; i < code; ++i)
+     {
+      if (size == sizeof(payload))
+       {
+        return false;
+       }
+      payload[size++] = data[pos++];
+     }
+    if ((code < 0xff) && (pos < len))
+     {
+      if (size == sizeof(payload))
+       {
+        return false;
+       }
+      payload[size++] = 0;
+     }
+   }
+  if (size < LTC6802Telemetry::headerBytes + 2)
+   {
+    return false;
+   }
+  if (LTC6802Telemetry::crc16(0xffff, payload, (byte)(size - 2)) != get16(&payload[size - 2]))
+   {
+    crcError = true;
+    return false;
+   }
+  if (payload[0] != LTC6802Telemetry::registerFrame)
+   {
+    return false;
+   }
+  frame = Frame();
+  frame.sequence = get16(&payload[1]);
+  frame.timestamp = get16(&payload[3]) | ((uint32_t)get16(&payload[5]) << 16);
+  frame.chip = payload[7];
+  frame.groups = payload[8];
+  const byte groups = frame.groups;
+  const byte sizes[6] = {LTC6802::cfgRegisters, LTC6802::cellRegisters, LTC6802::tmpRegisters, LTC6802::flgRegisters, 2 * LTC6802::maxCells, 7};
+  size_t expected = LTC6802Telemetry::headerBytes + 2;
+  for (int group = 0; group < 6; ++group)
+   {
+    if (groups & (1 << group))
+     {
+      expected += sizes[group];
+     }
+   }
+  if ((groups & 0xc0) || (expected != size))
+   {
+    return false;
+   }
+  const byte *in = &payload[LTC6802Telemetry::headerBytes];
+  if (groups & LTC6802Telemetry::cfgGroup)
+   {
+    memcpy(frame.cfg, in, LTC6802::cfgRegisters);
+    in += LTC6802::cfgRegisters;
+   }
+  if (groups & LTC6802Telemetry::cellsGroup)
+   {
+    memcpy(frame.cv, in, LTC6802::cellRegisters);
+    in += LTC6802::cellRegisters;
+    LTC6802::cellsDecode(frame.cv, frame.millivolts, true);
+   }
+  if (groups & LTC6802Telemetry::temperaturesGroup)
+   {
+    memcpy(frame.tmp, in, LTC6802::tmpRegisters);
+    in += LTC6802::tmpRegisters;
+    LTC6802::temperaturesDecode(frame.tmp, frame.temperatures);
+   }
+  if (groups & LTC6802Telemetry::flagsGroup)
+   {
+    memcpy(frame.flg, in, LTC6802::flgRegisters);
+    in += LTC6802::flgRegisters;
+   }
+  if (groups & LTC6802Telemetry::millivoltsGroup)
+   {
+    for (int cell = 0; cell < LTC6802::maxCells; ++cell)
+     {
+      frame.millivolts[cell] = get16(in);
+      in += 2;
+     }
+   }
+  if (groups & LTC6802Telemetry::decodedTemperaturesGroup)
+   {
+    frame.temperatures.etmp1 = get16(&in[0]);
+    frame.temperatures.etmp2 = get16(&in[2]);
+    frame.temperatures.internal = (int16_t)get16(&in[4]);
+    frame.temperatures.thsd = (in[6] & 1) != 0;
+    frame.temperatures.rev = in[6] >> 1;
+   }
+  return true;
+ }
+
+
+bool LTC6802TelemetryDecoder::feed(const byte data)
+ {
+  if (data != 0)
+   {
+    // Longer runs are garbage, wait for the next delimiter
+    if (pending.size() <= LTC6802Telemetry::maxFrameBytes)
+     {
+      pending.push_back(data);
+     }
+    return false;
+   }
+  if (pending.empty())
+   {
+    return false;
+   }
+  Frame decoded;
+  bool crcError;
+  const bool valid = (pending.size() <= LTC6802Telemetry::maxFrameBytes) && decode(pending.data(), pending.size(), decoded, crcError);
+  pending.clear();
+  if (!valid)
+   {
+    if (crcError)
+     {
+      ++statistics.crcErrors;
+     }
+    else
+     {
+      ++statistics.formatErrors;
+     }
+    return false;
+   }
+  if (synced)
+   {
+    statistics.lost += (uint16_t)(decoded.sequence - frame.sequence - 1);
+   }
+  synced = true;
+  frame = decoded;
+  ++statistics.frames;
+  return true;
+ }
+
+
+const LTC6802TelemetryDecoder::Frame &LTC6802TelemetryDecoder::getFrame() const
+ {
+  return frame;
+ }
+
+
+const LTC6802TelemetryDecoder::Statistics &LTC6802TelemetryDecoder::getStatistics() const
+ {
+  return statistics;
+ }
+
+
+void LTC6802TelemetryDecoder::csvHeader(FILE *const out)
+ {
+  fputs("sequence,timestamp_us,chip", out);
+  for (int cell = 1; cell <= LTC6802::maxCells; ++cell)
+   {
+    fprintf(out, ",cell%d_mV", cell);
+   }
+  fputs(",etmp1_code,etmp2_code,die_dC,thsd,rev,flags,cfg\n", out);
+ }
+
+
+void LTC6802TelemetryDecoder::csvLine(FILE *const out, const Frame &frame)
+ {
+  fprintf(out, "%u,%lu,%u", frame.sequence, (unsigned long)frame.timestamp, frame.chip);
+  for (int cell = 0; cell < LTC6802::maxCells; ++cell)
+   {
+    if (frame.hasCells())
+     {
+      fprintf(out, ",%u", frame.millivolts[cell]);
+     }
+    else
+     {
+      fputc(',', out);
+     }
+   }
+  if (frame.hasTemperatures())
+   {
+    const LTC6802::Temperatures &t = frame.temperatures;
+    fprintf(out, ",%u,%u,%d,%d,%u", t.etmp1, t.etmp2, t.internal, t.thsd ? 1 : 0, t.rev);
+   }
+  else
+   {
+    fputs(",,,,,", out);
+   }
+  if (frame.groups & LTC6802Telemetry::flagsGroup)
+   {
+    fprintf(out, ",%02x%02x%02x", frame.flg[2], frame.flg[1], frame.flg[0]);
+   }
+  else
+   {
+    fputc(',', out);
+   }
+  if (frame.groups & LTC6802Telemetry::cfgGroup)
+   {
+    fputc(',', out);
+    for (int i = 0; i < LTC6802::cfgRegisters; ++i)
+     {
+      fprintf(out, "%02x", frame.cfg[i]);
+     }
+   }
+  else
+   {
+    fputc(',', out);
+   }
+  fputc('\n', out);
+ }
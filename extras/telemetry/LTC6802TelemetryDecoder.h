@@ -0,0 +1,202 @@
+/**
+ * Copyright 2017, 2019 Dipl.-Inform. Kai Hofmann
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef LTC6802TELEMETRYDECODER_H_INCLUDED_
+  #define LTC6802TELEMETRYDECODER_H_INCLUDED_
+
+  #include <LTC6802.h>
+  #include <LTC6802Telemetry.h>
+  #include <stdio.h>
+  #include <vector>
+
+  /**
+   * Host decoder of LTC6802Telemetry frames.
+   *
+   * Collects stream bytes up to each 0x00 delimiter, reverses the COBS
+   * encoding, checks the CRC and unpacks the groups. Raw register groups are
+   * decoded with the driver code, so cell voltages and temperatures are
+   * available whether the MCU sent raw or decoded groups.
+   */
+  class LTC6802TelemetryDecoder
+   {
+    public:
+      /**
+       * Unpacked frame.
+       */
+      struct Frame
+       {
+        /**
+         * Sequence number.
+         */
+        uint16_t sequence;
+
+        /**
+         * MCU timestamp in microseconds.
+         */
+        uint32_t timestamp;
+
+        /**
+         * Chip id.
+         */
+        byte chip;
+
+        /**
+         * Groups contained in the frame.
+         */
+        byte groups;
+
+        /**
+         * Configuration registers (cfgGroup).
+         */
+        byte cfg[6];
+
+        /**
+         * Cell voltage registers (cellsGroup).
+         */
+        byte cv[18];
+
+        /**
+         * Temperature registers (temperaturesGroup).
+         */
+        byte tmp[5];
+
+        /**
+         * Flag registers (flagsGroup).
+         */
+        byte flg[3];
+
+        /**
+         * Cell voltages in mV (cellsGroup or millivoltsGroup).
+         */
+        uint16_t millivolts[12];
+
+        /**
+         * Temperatures (temperaturesGroup or decodedTemperaturesGroup).
+         */
+        LTC6802::Temperatures temperatures;
+
+        /**
+         * Check for cell voltages.
+         *
+         * @return true if millivolts is valid
+         */
+        bool hasCells() const {return (groups & (LTC6802Telemetry::cellsGroup | LTC6802Telemetry::millivoltsGroup)) != 0;}
+
+        /**
+         * Check for temperatures.
+         *
+         * @return true if temperatures is valid
+         */
+        bool hasTemperatures() const {return (groups & (LTC6802Telemetry::temperaturesGroup | LTC6802Telemetry::decodedTemperaturesGroup)) != 0;}
+       };
+
+      /**
+       * Stream counters.
+       */
+      struct Statistics
+       {
+        /**
+         * Valid frames.
+         */
+        unsigned long frames;
+
+        /**
+         * Frames with wrong CRC.
+         */
+        unsigned long crcErrors;
+
+        /**
+         * Frames with wrong COBS encoding, length or type.
+         */
+        unsigned long formatErrors;
+
+        /**
+         * Frames missing according to the sequence numbers.
+         */
+        unsigned long lost;
+       };
+
+      /**
+       * Decode one COBS encoded frame without delimiter.
+       *
+       * @param data Encoded bytes
+       * @param len Number of bytes
+       * @param frame Unpacked frame
+       * @param crcError Set true if only the CRC was wrong
+       * @return true if the frame is valid
+       */
+      static bool decode(const byte *data, size_t len, Frame &frame, bool &crcError);
+
+      /**
+       * Feed one stream byte.
+       *
+       * @param data Byte
+       * @return true if a valid frame is available by getFrame()
+       */
+      bool feed(byte data);
+
+      /**
+       * Get last valid frame.
+       *
+       * @return Frame
+       */
+      const Frame &getFrame() const;
+
+      /**
+       * Get stream counters.
+       *
+       * @return Counters
+       */
+      const Statistics &getStatistics() const;
+
+      /**
+       * Write the CSV header line.
+       *
+       * @param out Output file
+       */
+      static void csvHeader(FILE *out);
+
+      /**
+       * Write a frame as CSV line, missing groups leave their columns empty.
+       *
+       * @param out Output file
+       * @param frame Frame
+       */
+      static void csvLine(FILE *out, const Frame &frame);
+
+    private:
+      /**
+       * Bytes of the frame being received.
+       */
+      std::vector<byte> pending;
+
+      /**
+       * Last valid frame.
+       */
+      Frame frame = Frame();
+
+      /**
+       * Stream counters.
+       */
+      Statistics statistics = Statistics();
+
+      /**
+       * A frame was received before.
+       */
+      bool synced = false;
+
+   };
+
+#endif
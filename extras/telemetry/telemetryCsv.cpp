@@ -0,0 +1,58 @@
+/**
+ * Copyright 2017, 2019 Dipl.-Inform. Kai Hofmann
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Convert a captured LTC6802Telemetry stream to CSV.
+//
+// Build and run on the host:
+//
+//   g++ -std=c++17 -O2 -I../../src -I. ../../src/*.cpp LTC6802TelemetryDecoder.cpp telemetryCsv.cpp -o telemetryCsv
+//   ./telemetryCsv capture.bin > capture.csv
+//
+// Reads stdin without a file argument. Frame, CRC error and lost frame
+// counts go to stderr.
+#include <LTC6802TelemetryDecoder.h>
+
+
+int main(const int argc, const char *const argv[])
+ {
+  FILE *const in = (argc > 1) ? fopen(argv[1], "rb") : stdin;
+  if (in == 0)
+   {
+    perror(argv[1]);
+    return 1;
+   }
+  LTC6802TelemetryDecoder decoder;
+  LTC6802TelemetryDecoder::csvHeader(stdout);
+  byte buf[4096];
+  size_t len;
+  while ((len = fread(buf, 1, sizeof(buf), in)) > 0)
+   {
+    for (size_t i = 0; i < len; ++i)
+     {
+      if (decoder.feed(buf[i]))
+       {
+        LTC6802TelemetryDecoder::csvLine(stdout, decoder.getFrame());
+       }
+     }
+   }
+  if (in != stdin)
+   {
+    fclose(in);
+   }
+  const LTC6802TelemetryDecoder::Statistics &stats = decoder.getStatistics();
+  fprintf(stderr, "%lu frames, %lu crc errors, %lu format errors, %lu lost\n", stats.frames, stats.crcErrors, stats.formatErrors, stats.lost);
+  return 0;
+ }
@@ -14,307 +14,41 @@
  * limitations under the License.
  */
 #include <LTC6802.h>
-#include <SPI.h>
+#include <LTC6802Registers.h>
+#include <LTC6802PEC.h>
+#include <LTC6802Stats.h>
+#include <LTC6802Profile.h>
+#include <LTC6802Telemetry.h>
+#ifdef ARDUINO
+  #include <LTC6802SPITransport.h>
+#endif
 
 
-/**
- * SPI settings.
- */
-static const SPISettings spiSettings = SPISettings(1000000, MSBFIRST, SPI_MODE3);
-
-/**
- * Write configuration register group.
- */
-static const byte WRCFG   = 0x01;
-
-/**
- * Read configuration register group.
- */
-static const byte RDCFG   = 0x02;
-
-/**
- * Read cellvoltage register group.
- */
-static const byte RDCV    = 0x04;
-
-/**
- * Read flag register group.
- */
-static const byte RDFLG   = 0x06;
-
-/**
- * Read temperature register group.
- */
-static const byte RDTMP   = 0x08;
-
-/**
- * Start cell voltage A/D conversion and poll status.
- *
- * | 0x00 : all cell voltage inputs
- * | 0x01 : cell 1 only
- * | 0x02 : cell 2 only
- * | 0x03 : cell 3 only
- * | 0x04 : cell 4 only
- * | 0x05 : cell 5 only
- * | 0x06 : cell 6 only
- * | 0x07 : cell 7 only
- * | 0x08 : cell 8 only
- * | 0x09 : cell 9 only
- * | 0x0a : cell 10 only
- * | 0x0b : cell 11 only, if CELL10 bit=0
- * | 0x0c : cell 12 only, if CELL10 bit=0
- * | 0x0e : cell self test 1; all CV=0x555
- * | 0x0f : cell self test 2; all CV=0xaaa
- */
-static const byte STCVAD  = 0x10;
-
-/**
- * Start Open-Wire A/D conversion and poll status.
- *
- * | 0x00 : all cell voltage inputs
- * | 0x01 : cell 1 only
- * | 0x02 : cell 2 only
- * | 0x03 : cell 3 only
- * | 0x04 : cell 4 only
- * | 0x05 : cell 5 only
- * | 0x06 : cell 6 only
- * | 0x07 : cell 7 only
- * | 0x08 : cell 8 only
- * | 0x09 : cell 9 only
- * | 0x0a : cell 10 only
- * | 0x0b : cell 11 only, if CELL10 bit=0
- * | 0x0c : cell 12 only, if CELL10 bit=0
- * | 0x0e : cell self test 1; all CV=0x555
- * | 0x0f : cell self test 2; all CV=0xaaa
- */
-static const byte STOWAD  = 0x20;
-
-/**
- * Start temperature A/D conversion and poll status.
- *
- * | 0x00 : all temperature inputs
- * | 0x01 : external temp 1 only
- * | 0x02 : external temp 2 only
- * | 0x03 : internal temp only
- * | 0x0e : temp self test 1; all TMP=0x555
- * | 0x0f : temp self test 2; all TMP=0xaaa
- */
-static const byte STTMPAD = 0x30;
-
-/**
- * Poll A/D convertr status.
- */
-static const byte PLADC   = 0x40;
-
-/**
- * Poll interrupt status.
- */
-static const byte PLINT   = 0x50;
-
-/**
- * Start cell voltage A/D conversion and poll status, with discharge permitted.
- *
- * | 0x00 : all cell voltage inputs
- * | 0x01 : cell 1 only
- * | 0x02 : cell 2 only
- * | 0x03 : cell 3 only
- * | 0x04 : cell 4 only
- * | 0x05 : cell 5 only
- * | 0x06 : cell 6 only
- * | 0x07 : cell 7 only
- * | 0x08 : cell 8 only
- * | 0x09 : cell 9 only
- * | 0x0a : cell 10 only
- * | 0x0b : cell 11 only, if CELL10 bit=0
- * | 0x0c : cell 12 only, if CELL10 bit=0
- * | 0x0e : cell self test 1; all CV=0x555
- * | 0x0f : cell self test 2; all CV=0xaaa
- */
-static const byte STCDC   = 0x60;
-
-/**
- * Start open-Wire A/D conversions and poll status, with Discharge Permitted.
- *
- * | 0x00 : all cell voltage inputs
- * | 0x01 : cell 1 only
- * | 0x02 : cell 2 only
- * | 0x03 : cell 3 only
- * | 0x04 : cell 4 only
- * | 0x05 : cell 5 only
- * | 0x06 : cell 6 only
- * | 0x07 : cell 7 only
- * | 0x08 : cell 8 only
- * | 0x09 : cell 9 only
- * | 0x0a : cell 10 only
- * | 0x0b : cell 11 only, if CELL10 bit=0
- * | 0x0c : cell 12 only, if CELL10 bit=0
- * | 0x0e : cell self test 1; all CV=0x555
- * | 0x0f : cell self test 2; all CV=0xaaa
- */
-static const byte STOWDC  = 0x70;
-
-/**
- * Configuration register 0 watchdog timer bit.
- */
-static const byte CFG0_WDT_BIT    = 7;
-
-/**
- * Configuration register 0 GPIO2 bit.
- */
-static const byte CFG0_GPIO2_BIT  = 6;
-
-/**
- * Configuration register 0 GPIO1 bit.
- */
-static const byte CFG0_GPIO1_BIT  = 5;
-
-/**
- * Configuration register 0 level polling mode bit.
- */
-static const byte CFG0_LVLPL_BIT  = 4;
-
-/**
- * Configuration register 0 10-cell mode bit.
- */
-static const byte CFG0_CELL10_BIT = 3;
-
-// static const byte CFG0_CDC_BITS   = 0-2;
-// static const byte CFG1_DCC_BITS   = 0-7;
-// static const byte CFG2_DCC_BITS   = 0-3;
-// static const byte CFG2_MCI_BITS   = 4-7;
-// static const byte CFG3_MCI_BITS   = 0-7;
-
-/**
- * Configuration register 0 watchdog timer bitmask.
- */
-static const byte CFG0_WDT_MSK    = 0x80;
-
-/**
- * Configuration register 0 GPIO2 bitmask.
- */
-static const byte CFG0_GPIO2_MSK  = 0x40;
-
-/**
- * Configuration register 0 GPIO1 bitmask.
- */
-static const byte CFG0_GPIO1_MSK  = 0x20;
-
-/**
- * Configuration register 0 level polling bitmask.
- */
-static const byte CFG0_LVLPL_MSK  = 0x10;
-
-/**
- * Configuration register 0 10-cell mode bitmask.
- */
-static const byte CFG0_CELL10_MSK = 0x08;
-
-/**
- * Configuration register 0 comparator duty cycle bitmask.
- */
-static const byte CFG0_CDC_MSK    = 0x07;
-
-/**
- * Configuration register 1 discharge cell bitmask.
- */
-static const byte CFG1_DCC_MSK    = 0xff;
-
-/**
- * Configuration register 2 discharge cell bitmask.
- */
-static const byte CFG2_DCC_MSK    = 0x0f;
-
-/**
- * Configuration register 2 mask cell interrupts bitmask.
- */
-static const byte CFG2_MCI_MSK    = 0xf0;
-
-/**
- * Configuration register 3 mask cell interrupts bitmask.
- */
-static const byte CFG3_MCI_MSK    = 0xff;
-
-
-/**
- * Configuration register 0 watchdog timer inverse bitmask.
- */
-static const byte CFG0_WDT_INVMSK    = 0x7f;
-
-/**
- * Configuration register 0 GPIO2 inverse bitmask.
- */
-static const byte CFG0_GPIO2_INVMSK  = 0xbf;
-
-/**
- * Configuration register 0 GPIO1 inverse bitmask.
- */
-static const byte CFG0_GPIO1_INVMSK  = 0xdf;
-
-/**
- * Configuration register 0 level polling mode inverse bitmask.
- */
-static const byte CFG0_LVLPL_INVMSK  = 0xef;
-
-/**
- * Configuration register 0 10-cell mode inverse bitmask.
- */
-static const byte CFG0_CELL10_INVMSK = 0xf7;
-
-/**
- * Configuration register 0 comparator duty cycle inverse bitmask.
- */
-static const byte CFG0_CDC_INVMSK    = 0xf8;
-
-/**
- * Configuration register 1 discharge cell inverse bitmask.
- */
-static const byte CFG1_DCC_INVMSK    = 0x00;
-
-/**
- * Configuration register 2 discharge cell inverse bitmask.
- */
-static const byte CFG2_DCC_INVMSK    = 0xf0;
-
-/**
- * Configuration register 2 mask cell interrupts inverse bitmask.
- */
-static const byte CFG2_MCI_INVMSK    = 0x0f;
-
-/**
- * Configuration register 3 mask cell interrupts inverse bitmask.
- */
-static const byte CFG3_MCI_INVMSK    = 0x00;
-
-
-void LTC6802::initSPI(const byte pinMOSI, const byte pinMISO, const byte pinCLK)
+#ifdef ARDUINO
+void LTC6802::initSPI(const byte pinMOSI, const byte pinMISO, const byte pinCLK, const unsigned long clock)
  {
-  // TODO parameters for different arduinos (pins, clock)
-  pinMode(pinMOSI, OUTPUT);
-  pinMode(pinMISO, INPUT);
-  pinMode(pinCLK, OUTPUT);
-
-  // SPI.setBitOrder(MSBFIRST);
-  // SPI.setDataMode(SPI_MODE3);
-  // SPI.setClockDivider(SPI_CLOCK_DIV16);
-  // SPI.begin();
-
-  // SPI.begin(ETHERNET_SHIELD_SPI_CS);
-  // SPI.setClockDivider(ETHERNET_SHIELD_SPI_CS, SPI_CLOCK_DIV16);
-  // SPI.setDataMode(ETHERNET_SHIELD_SPI_CS, SPI_MODE3);
+  LTC6802SPITransport::standard().setClock(clock);
+  LTC6802SPITransport::standard().begin(pinMOSI, pinMISO, pinCLK);
  }
 
 
 void LTC6802::destroySPI()
  {
-  // SPI.end();
+  LTC6802SPITransport::standard().end();
  }
 
 
 LTC6802::LTC6802(const byte address, const byte csPin)
- : address(address), csPin(csPin)
+ : LTC6802(LTC6802SPITransport::standard(), address, csPin)
  {
-  pinMode(csPin, OUTPUT);
-  digitalWrite(csPin, HIGH);
+ }
+#endif
+
+
+LTC6802::LTC6802(LTC6802Transport &bus, const byte address, const byte csPin)
+ : bus(bus), address(address), csPin(csPin)
+ {
+  bus.attach(csPin);
   for (int i = 0; i < cfgRegisters; ++i)
    {
     CFG[i] = 0;
@@ -342,57 +76,163 @@ LTC6802::~LTC6802()
 */
 
 
-void LTC6802::measure(const byte cmd, const bool broadcast) const
+void LTC6802::measure(const byte cmd, const bool broadcast)
  {
-  SPI.beginTransaction(spiSettings);
-  digitalWrite(csPin, LOW);
-  if (!broadcast)
+  byte frame[2] = {this->address, cmd};
+  bus.select(csPin);
+  if (broadcast)
    {
-    SPI.transfer(this->address);
+    bus.transfer(&frame[1], 1);
    }
-  SPI.transfer(cmd);
+  else
+   {
+    bus.transfer(frame, 2);
+   }
+  bus.deselect(csPin);
+  converting = true;
+  conversionStart = micros();
+ }
+
 
-  digitalWrite(csPin, HIGH);
-  SPI.endTransaction();
-  // check SDO for measure finished
+LTC6802::Status LTC6802::readRegisters(const byte cmd, const byte numOfRegisters, byte *const arr)
+ {
+  // Address, command, registers and PEC go out in one transfer
+  byte frame[2 + cellRegisters + 1];
+  const byte frameBytes = 2 + numOfRegisters + 1;
+  for (int attempt = 0; attempt <= retries; ++attempt)
+   {
+    if (attempt > 0)
+     {
+      LTC6802_PROFILE_RETRY();
+     }
+    frame[0] = this->address; // TODO broadcast
+    for (int i = 1; i < frameBytes; ++i)
+     {
+      frame[i] = cmd;
+     }
+    bus.select(csPin);
+    bus.transfer(frame, frameBytes);
+    bus.deselect(csPin);
+
+    for (int i = 0; i < numOfRegisters; ++i)
+     {
+      arr[i] = frame[2 + i];
+     }
+    if (LTC6802PEC::check(&frame[2], numOfRegisters))
+     {
+      return ok;
+     }
+    if (pecErrors < 0xff)
+     {
+      ++pecErrors;
+     }
+   }
+  return pecError;
  }
 
 
- void LTC6802::read(const byte cmd, const byte numOfRegisters, byte *const arr) // TODO eliminate buffer overflow risk
-  {
-   SPI.beginTransaction(spiSettings);
-   digitalWrite(csPin, LOW);
-   if (true)
-    {
-     SPI.transfer(this->address); // TODO broadcast
-    }
-   SPI.transfer(cmd);
+LTC6802::Status LTC6802::waitConversion()
+ {
+  Status status;
+  while ((status = poll()) == busy)
+   {
+    LTC6802_PROFILE_POLL();
+    delayMicroseconds(pollInterval);
+   }
+  return status;
+ }
 
-   for (int i = 0; i < numOfRegisters; ++i)
-    {
-     arr[i] = SPI.transfer(cmd);
-    }
-   /* byte pec = */ SPI.transfer(cmd);
 
-   digitalWrite(csPin, HIGH);
-   SPI.endTransaction();
-  }
+bool LTC6802::isConversionDone()
+ {
+  byte frame[3] = {this->address, PLADC, PLADC};
+  bus.select(csPin);
+  bus.transfer(frame, 3);
+  bus.deselect(csPin);
+  // SDO is held low while the A/D converter is busy; when done it stays high (LVLPL set) or toggles at 1kHz (LVLPL clear)
+  return (frame[2] != 0x00);
+ }
 
 
-void LTC6802::readValues(const byte cmd, const byte numOfRegisters, byte *const arr)
+LTC6802::Status LTC6802::poll()
  {
-  do
+  if (!converting)
    {
-    read(cmd, numOfRegisters, arr);
+    return ok;
    }
-  while (arr[0] == 0xff);
+  if (isConversionDone())
+   {
+    converting = false;
+    return ok;
+   }
+  if ((micros() - conversionStart) > conversionTimeout)
+   {
+    converting = false;
+    return timeout;
+   }
+  return busy;
  }
 
 
- void LTC6802::flagsRead()
-  {
-   read(RDFLG, flgRegisters, FLG);
-  }
+void LTC6802::setConversionTimeout(const unsigned long timeout)
+ {
+  conversionTimeout = timeout;
+ }
+
+
+void LTC6802::setRetries(const byte retries)
+ {
+  this->retries = retries;
+ }
+
+
+byte LTC6802::getPecErrors() const
+ {
+  return pecErrors;
+ }
+
+
+void LTC6802::resetPecErrors()
+ {
+  pecErrors = 0;
+ }
+
+
+LTC6802::Status LTC6802::flagsRead()
+ {
+  LTC6802_PROFILE_SCOPE(flagsRead);
+  return read(RDFLG, FLG);
+ }
+
+
+void LTC6802::flagsDecode(const byte *const flg, word &overvoltage, word &undervoltage)
+ {
+  // Two bits per cell, UV below OV, four cells per register
+  overvoltage = 0;
+  undervoltage = 0;
+  for (byte cell = 0; cell < maxCells; ++cell)
+   {
+    const byte flags = flg[cell / 4] >> ((cell % 4) * 2);
+    undervoltage |= (word)(flags & 0x01) << cell;
+    overvoltage |= (word)((flags >> 1) & 0x01) << cell;
+   }
+ }
+
+
+void LTC6802::flagsGet(word &overvoltage, word &undervoltage) const
+ {
+  flagsDecode(FLG, overvoltage, undervoltage);
+ }
+
+
+bool LTC6802::isInterruptPending()
+ {
+  byte frame[3] = {this->address, PLINT, PLINT};
+  bus.select(csPin);
+  bus.transfer(frame, 3);
+  bus.deselect(csPin);
+  return (frame[2] == 0x00); // SDO is held low while a comparator flag is set
+ }
 
 
  void LTC6802::flagsDebugOutput()
@@ -406,27 +246,40 @@ void LTC6802::readValues(const byte cmd, const byte numOfRegisters, byte *const
   }
 
 
-void LTC6802::cfgRead()
+byte LTC6802::telemetryEncode(LTC6802Telemetry &telemetry, const byte groups) const
  {
-  read(RDCFG, cfgRegisters, CFG);
+  return telemetry.encode(address, groups, CFG, CV, TMP, FLG);
+ }
+
+
+LTC6802::Status LTC6802::cfgRead()
+ {
+  LTC6802_PROFILE_SCOPE(cfgRead);
+  return read(RDCFG, CFG);
  }
 
 
 void LTC6802::cfgWrite(const bool broadcast) const
  {
-  SPI.beginTransaction(spiSettings);
-  digitalWrite(csPin, LOW);
-  if (!broadcast)
+  LTC6802_PROFILE_SCOPE(cfgWrite);
+  byte frame[2 + cfgRegisters + 1];
+  frame[0] = this->address;
+  frame[1] = WRCFG;
+  for (int i = 0; i < cfgRegisters; ++i)
    {
-    SPI.transfer(this->address);
+    frame[2 + i] = this->CFG[i];
    }
-  SPI.transfer(WRCFG);
-  for (int i = 0; i < cfgRegisters; ++i)
+  frame[2 + cfgRegisters] = LTC6802PEC::calculate(this->CFG, cfgRegisters);
+  bus.select(csPin);
+  if (broadcast)
+   {
+    bus.transfer(&frame[1], sizeof(frame) - 1);
+   }
+  else
    {
-    SPI.transfer(this->CFG[i]);
+    bus.transfer(frame, sizeof(frame));
    }
-  digitalWrite(csPin, HIGH);
-  SPI.endTransaction();
+  bus.deselect(csPin);
  }
 
 
@@ -536,39 +389,65 @@ void LTC6802::cfgSetMCI(const word mci)
  }
 
 
-byte LTC6802::cfgGetVUV() const // TODO float vs double
+byte LTC6802::cfgGetVUV() const
+ {
+  return CFG[4];
+ }
+
+
+void LTC6802::cfgSetVUV(const byte vuv)
+ {
+  CFG[4] = vuv;
+ }
+
+
+byte LTC6802::cfgGetVOV() const
  {
-  return (CFG[4] * 16 / 1.5);
+  return CFG[5];
  }
 
 
-void LTC6802::cfgSetVUV(const byte vuv) // TODO float vs double
+void LTC6802::cfgSetVOV(const byte vov)
  {
-  CFG[4] = vuv * 1.5 / 16;
+  CFG[5] = vov;
  }
 
 
-byte LTC6802::cfgGetVOV() const // TODO float vs double
+word LTC6802::cfgGetUndervoltage() const
  {
-  return (CFG[5] * 16 / 1.5);
+  return thresholdDecode(CFG[4]);
  }
 
 
-void LTC6802::cfgSetVOV(const byte vov) // TODO float vs double
+void LTC6802::cfgSetUndervoltage(const word millivolts)
  {
-  CFG[5] = vov * 1.5 / 16;
+  CFG[4] = undervoltageEncode(millivolts);
+ }
+
+
+word LTC6802::cfgGetOvervoltage() const
+ {
+  return thresholdDecode(CFG[5]);
+ }
+
+
+void LTC6802::cfgSetOvervoltage(const word millivolts)
+ {
+  CFG[5] = overvoltageEncode(millivolts);
  }
 
 
 void LTC6802::temperatureMeasure()
  {
+  LTC6802_PROFILE_SCOPE(temperatureMeasure);
   measure(STTMPAD, false);
  }
 
 
-void LTC6802::temperatureRead()
+LTC6802::Status LTC6802::temperatureRead()
  {
-  readValues(RDTMP, tmpRegisters, TMP);
+  LTC6802_PROFILE_SCOPE(temperatureRead);
+  return readValues(RDTMP, TMP);
  }
 
 
@@ -603,15 +482,66 @@ void LTC6802::temperatureDebugOutput() const
  }
 
 
+void LTC6802::temperaturesDecode(const byte *const tmp, Temperatures &temperatures)
+ {
+  // ETMP1[7:0] | ETMP2[3:0] ETMP1[11:8] | ETMP2[11:4] | ITMP[7:0] | REV THSD ITMP[11:8]
+  const uint32_t lanes = cellsDecodePair(tmp, false);
+  temperatures.etmp1 = (word)lanes;
+  temperatures.etmp2 = (word)(lanes >> 16);
+  const word itmp = tmp[3] | ((tmp[4] & 0x0f) << 8);
+  // itmp * 1.5mV / 8mV per Kelvin - 273.15, in 0.1 degree rounded: (itmp * 30 - 43704) / 16
+  temperatures.internal = (int16_t)(((int32_t)itmp * 30 - 43704 + 8) >> 4);
+  temperatures.thsd = (tmp[4] & 0x10) != 0;
+  temperatures.rev = tmp[4] >> 5;
+ }
+
+
+void LTC6802::temperaturesGet(Temperatures &temperatures) const
+ {
+  temperaturesDecode(TMP, temperatures);
+ }
+
+
 void LTC6802::cellsMeasure()
  {
+  LTC6802_PROFILE_SCOPE(cellsMeasure);
   measure(STCVAD, false);
  }
 
 
-void LTC6802::cellsRead()
+LTC6802::Status LTC6802::cellsRead()
  {
-  readValues(RDCV, cellRegisters, CV);
+  LTC6802_PROFILE_SCOPE(cellsRead);
+  const Status status = readValues(RDCV, CV);
+  if ((status == ok) && (stats != 0))
+   {
+    stats->begin();
+    for (byte reg = 0; reg < cellRegisters; reg += 3)
+     {
+      const uint32_t lanes = cellsDecodePair(&CV[reg], true);
+      stats->add((uint16_t)lanes);
+      stats->add((uint16_t)(lanes >> 16));
+     }
+    stats->end();
+   }
+  return status;
+ }
+
+
+void LTC6802::cellMeasure(const byte cell)
+ {
+  measure(STCVAD | (cell + 1), false);
+ }
+
+
+LTC6802::Status LTC6802::cellRead(const byte cell, uint16_t *const millivolts)
+ {
+  const Status status = readValues(RDCV, CV);
+  if (status == ok)
+   {
+    millivolts[cell] = cellDecode(CV, cell, true);
+   }
+  return status;
  }
 
 
@@ -660,3 +590,34 @@ void LTC6802::cellsDebugOutput() const
   Serial.print(", ");
   Serial.println(cellvolts[11] * 1.5 / 1000);
  }
+
+
+void LTC6802::cellsDecode(const byte *cv, uint16_t *cells, const bool millivolts)
+ {
+  for (byte pair = 0; pair < maxCells / 2; ++pair)
+   {
+    const uint32_t lanes = cellsDecodePair(cv, millivolts);
+    cells[0] = (uint16_t)lanes;
+    cells[1] = (uint16_t)(lanes >> 16);
+    cv += 3;
+    cells += 2;
+   }
+ }
+
+
+void LTC6802::cellsGetCodes(uint16_t *const codes) const
+ {
+  cellsDecode(CV, codes, false);
+ }
+
+
+void LTC6802::cellsGetMillivolts(uint16_t *const millivolts) const
+ {
+  cellsDecode(CV, millivolts, true);
+ }
+
+
+void LTC6802::setStats(LTC6802Stats *const stats)
+ {
+  this->stats = stats;
+ }
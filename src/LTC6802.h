@@ -16,7 +16,11 @@
 #ifndef LTC6802_H_INCLUDED_
   #define LTC6802_H_INCLUDED_
 
-  #include <Arduino.h>
+  #include <LTC6802Platform.h>
+  #include <LTC6802Transport.h>
+
+  class LTC6802Stats;
+  class LTC6802Telemetry;
 
   // 57./58./59. namespace?
   // 72./73./74./75. exceptions
@@ -30,6 +34,69 @@
   class LTC6802
    {
     public:
+      /**
+       * Result of operations that wait for the chip.
+       */
+      enum Status
+       {
+        /**
+         * Operation completed.
+         */
+        ok,
+
+        /**
+         * Conversion still running.
+         */
+        busy,
+
+        /**
+         * Conversion did not complete within the conversion timeout.
+         */
+        timeout,
+
+        /**
+         * Register data failed the packet error code check (after all retries).
+         */
+        pecError,
+
+        /**
+         * A/D self test returned a wrong pattern.
+         */
+        selfTestError
+       };
+
+      /**
+       * Decoded temperature register group.
+       */
+      struct Temperatures
+       {
+        /**
+         * External temperature 1 A/D code (1.5mV per count).
+         */
+        word etmp1;
+
+        /**
+         * External temperature 2 A/D code (1.5mV per count).
+         */
+        word etmp2;
+
+        /**
+         * Die temperature in 0.1 degree celsius.
+         */
+        int16_t internal;
+
+        /**
+         * Thermal shutdown occurred.
+         */
+        bool thsd;
+
+        /**
+         * Chip revision.
+         */
+        byte rev;
+       };
+
+  #ifdef ARDUINO
       /**
        * Init SPI bus for LTC6802 chips.
        *
@@ -38,8 +105,9 @@
        * @param pinMOSI Pin for master out slave in
        * @param pinMISO Pin for master in slave out
        * @param pinCLK Pin for clock
+       * @param clock SPI clock rate in Hz
        */
-      static void initSPI(byte pinMOSI = 11, byte pinMISO = 12, byte pinCLK = 13);
+      static void initSPI(byte pinMOSI = 11, byte pinMISO = 12, byte pinCLK = 13, unsigned long clock = 1000000);
 
       /**
        * Destroy SPI bus.
@@ -47,25 +115,69 @@
        * Call only one time, and not for each chip!
        */
       static void destroySPI();
+  #endif
 
 
       /**
-       * Constructor.
+       * Number of LTC6802 configuration registers.
+       */
+      static const byte cfgRegisters = 6;
+
+      /**
+       * Number of LTC6802 temperature registers.
+       */
+      static const byte tmpRegisters = 5;
+
+      /**
+       * Number of LTC6802 cell registers.
+       */
+      static const byte cellRegisters = 18;
+
+      /**
+       * Number of LTC6802 flag registers.
+       */
+      static const byte flgRegisters = 3;
+
+      /**
+       * Number of maximum cells connected to LTC6802.
+       */
+      static const byte maxCells = 12;
+
+      /**
+       * Comparison voltage step of VUV and VOV in mV (16 * 1.5mV).
+       */
+      static const byte thresholdStep = 24;
+
+  #ifdef ARDUINO
+      /**
+       * Constructor using the default SPI bus.
        *
        * @param address Chip address on SPI bus
        * @param csPin Chip select pin
        */
       explicit LTC6802(byte address, byte csPin);
+  #endif
+
+      /**
+       * Constructor.
+       *
+       * @param bus Transport the chip is connected to
+       * @param address Chip address on SPI bus
+       * @param csPin Chip select pin
+       */
+      LTC6802(LTC6802Transport &bus, byte address, byte csPin);
 
       // ~LTC6802();
 
       /**
        * Read configuration from chip registers.
+       *
+       * @return ok; pecError
        */
-      void cfgRead();
+      Status cfgRead();
 
       /**
-       * Write configuration to chip registers.
+       * Write configuration to chip registers, followed by its PEC.
        *
        * @param broadcast Send as broadcast
        */
@@ -172,31 +284,98 @@
       /**
        * Get undervoltage comparison voltage from configuration.
        *
-       * @return Voltage (default: 0 or factory programmed)
+       * @return VUV register, threshold VUV * 24mV (default: 0 or factory programmed)
        */
       byte cfgGetVUV() const;
 
       /**
        * Set undervoltage comparison voltage in configuration.
        *
-       * @param vuv Voltage
+       * @param vuv VUV register, threshold VUV * 24mV; 0 : comparison off
        */
       void cfgSetVUV(byte vuv);
 
       /**
        * Get overvoltage comparison voltage from configuration.
        *
-       * @return Voltage (default: 0 or factory programmed)
+       * @return VOV register, threshold VOV * 24mV (default: 0 or factory programmed)
        */
       byte cfgGetVOV() const;
 
       /**
        * Set overvoltage comparison voltage in configuration.
        *
-       * @param vov Voltage
+       * @param vov VOV register, threshold VOV * 24mV; 0 : comparison off
        */
       void cfgSetVOV(byte vov);
 
+      /**
+       * Get undervoltage threshold from configuration.
+       *
+       * @return Threshold in mV, 0 : comparison off
+       */
+      word cfgGetUndervoltage() const;
+
+      /**
+       * Set undervoltage threshold in configuration.
+       *
+       * @param millivolts Threshold in mV, rounded up to the next 24mV step; 0 : comparison off
+       */
+      void cfgSetUndervoltage(word millivolts);
+
+      /**
+       * Get overvoltage threshold from configuration.
+       *
+       * @return Threshold in mV, 0 : comparison off
+       */
+      word cfgGetOvervoltage() const;
+
+      /**
+       * Set overvoltage threshold in configuration.
+       *
+       * @param millivolts Threshold in mV, rounded down to the previous 24mV step; 0 : comparison off
+       */
+      void cfgSetOvervoltage(word millivolts);
+
+      /**
+       * Encode an undervoltage threshold.
+       *
+       * Rounds up, so the comparator never trips later than requested.
+       *
+       * @param millivolts Threshold in mV
+       * @return VUV register
+       */
+      static byte undervoltageEncode(const word millivolts)
+       {
+        const word vuv = (millivolts + thresholdStep - 1) / thresholdStep;
+        return (vuv > 0xff) ? 0xff : (byte)vuv;
+       }
+
+      /**
+       * Encode an overvoltage threshold.
+       *
+       * Rounds down, so the comparator never trips later than requested.
+       *
+       * @param millivolts Threshold in mV
+       * @return VOV register, at least 1 for non zero thresholds
+       */
+      static byte overvoltageEncode(const word millivolts)
+       {
+        const word vov = millivolts / thresholdStep;
+        return (vov > 0xff) ? 0xff : ((vov == 0) && (millivolts != 0)) ? 1 : (byte)vov;
+       }
+
+      /**
+       * Decode a VUV or VOV register.
+       *
+       * @param threshold VUV or VOV register
+       * @return Threshold in mV
+       */
+      static word thresholdDecode(const byte threshold)
+       {
+        return threshold * thresholdStep;
+       }
+
       /**
        * Measure temperatures on chip.
        */
@@ -204,8 +383,12 @@
 
       /**
        * Read temperatures from chip.
+       *
+       * Waits for a running temperature conversion first.
+       *
+       * @return ok; timeout when the conversion did not finish (registers are not read); pecError
        */
-      void temperatureRead();
+      Status temperatureRead();
 
       /**
        * Write temperatures to serial.
@@ -214,6 +397,23 @@
        */
       void temperatureDebugOutput() const;
 
+      /**
+       * Decode a temperature register group with integer math only.
+       *
+       * External temperatures stay A/D codes, see LTC6802Thermistor.
+       *
+       * @param tmp 5 temperature registers
+       * @param temperatures Decoded temperatures
+       */
+      static void temperaturesDecode(const byte *tmp, Temperatures &temperatures);
+
+      /**
+       * Get temperatures of the last read.
+       *
+       * @param temperatures Decoded temperatures
+       */
+      void temperaturesGet(Temperatures &temperatures) const;
+
       /**
        * Measure cell voltages on chip.
        */
@@ -221,8 +421,12 @@
 
       /**
        * Read cell voltages from chip.
+       *
+       * Waits for a running cell conversion first.
+       *
+       * @return ok; timeout when the conversion did not finish (registers are not read); pecError
        */
-      void cellsRead();
+      Status cellsRead();
 
       /**
        * Write cell voltages to serial.
@@ -231,51 +435,194 @@
        */
       void cellsDebugOutput() const;
 
+      /**
+       * Measure a single cell voltage on chip.
+       *
+       * Converts in about 1/12 of the time of all cells.
+       *
+       * @param cell Cell index 0-11
+       */
+      void cellMeasure(byte cell);
+
+      /**
+       * Read a single cell voltage from chip.
+       *
+       * Waits for a running cell conversion first. The register group is read
+       * completely to keep the PEC check; the other cells keep their values.
+       * Pack statistics are not fed.
+       *
+       * @param cell Cell index 0-11
+       * @param millivolts Array for 12 voltages in mV, only the entry of cell is written
+       * @return ok; timeout when the conversion did not finish (registers are not read); pecError
+       */
+      Status cellRead(byte cell, uint16_t *millivolts);
+
+      /**
+       * Decode a cell voltage register group with integer math only.
+       *
+       * @param cv 18 cell voltage registers
+       * @param cells Array for 12 values
+       * @param millivolts true : values in mV (rounded); false : raw A/D codes (1.5mV per count)
+       */
+      static void cellsDecode(const byte *cv, uint16_t *cells, bool millivolts);
+
+      /**
+       * Decode the two cells packed into 3 cell voltage registers.
+       *
+       * Both 12 bit codes are spread into 16 bit lanes of one 32 bit word and
+       * scaled together.
+       *
+       * @param cv 3 cell voltage registers
+       * @param millivolts true : values in mV (rounded); false : raw A/D codes
+       * @return First cell in bits 0-15, second cell in bits 16-31
+       */
+      static uint32_t cellsDecodePair(const byte *const cv, const bool millivolts)
+       {
+        // C1[7:0] | C2[3:0] C1[11:8] | C2[11:4]
+        const uint32_t packed = (uint32_t)cv[0] | ((uint32_t)cv[1] << 8) | ((uint32_t)cv[2] << 16);
+        const uint32_t lanes = (packed & 0x00000fffUL) | ((packed << 4) & 0x0fff0000UL);
+        // code * 1.5 rounded; lane values stay below 2^15, the mask drops the bit shifted across lanes
+        return millivolts ? (((lanes * 3 + 0x00010001UL) >> 1) & 0x7fff7fffUL) : lanes;
+       }
+
+      /**
+       * Decode a single cell from a cell voltage register group.
+       *
+       * @param cv 18 cell voltage registers
+       * @param cell Cell index 0-11
+       * @param millivolts true : value in mV (rounded); false : raw A/D code
+       * @return Cell value
+       */
+      static uint16_t cellDecode(const byte *const cv, const byte cell, const bool millivolts)
+       {
+        const uint32_t lanes = cellsDecodePair(&cv[(cell >> 1) * 3], millivolts);
+        return (uint16_t)((cell & 1) ? (lanes >> 16) : lanes);
+       }
+
+      /**
+       * Get raw cell voltage A/D codes of the last read.
+       *
+       * @param codes Array for 12 codes (1.5mV per count)
+       */
+      void cellsGetCodes(uint16_t *codes) const;
+
+      /**
+       * Get cell voltages of the last read.
+       *
+       * @param millivolts Array for 12 voltages in mV
+       */
+      void cellsGetMillivolts(uint16_t *millivolts) const;
+
+      /**
+       * Attach pack statistics fed by every successful cellsRead().
+       *
+       * @param stats Statistics, 0 to detach
+       */
+      void setStats(LTC6802Stats *stats);
+
+      /**
+       * Poll A/D converter status once (PLADC).
+       *
+       * With toggle polling (LVLPL clear, the reset default) SDO toggles at
+       * 1kHz after the conversion, so a poll in its low half still reads busy.
+       *
+       * @return true if no conversion is running
+       */
+      bool isConversionDone();
+
+      /**
+       * Check progress of the last started conversion without blocking.
+       *
+       * @return ok : finished or none started; busy : still running; timeout : exceeded conversion timeout
+       */
+      Status poll();
+
+      /**
+       * Set the time after which a conversion is reported as failed.
+       *
+       * @param timeout Microseconds (default 20000)
+       */
+      void setConversionTimeout(unsigned long timeout);
+
       /**
        * Read flag register group from chip.
+       *
+       * @return ok; pecError
        */
-      void flagsRead();
+      Status flagsRead();
 
       /**
-       * Write flag register group to serial.
+       * Decode the comparator flags of a flag register group.
        *
-       * @Deprecated Don't use anymore
+       * @param flg 3 flag registers
+       * @param overvoltage bit n : cell n+1 above VOV
+       * @param undervoltage bit n : cell n+1 below VUV
        */
-      void flagsDebugOutput();
+      static void flagsDecode(const byte *flg, word &overvoltage, word &undervoltage);
 
-      // bool operator==(const LTC6802& obj1, const LTC6802& obj2);
-      // bool operator!=(const LTC6802& obj1, const LTC6802& obj2);
+      /**
+       * Get the comparator flags of the last flagsRead().
+       *
+       * @param overvoltage bit n : cell n+1 above VOV
+       * @param undervoltage bit n : cell n+1 below VUV
+       */
+      void flagsGet(word &overvoltage, word &undervoltage) const;
 
-    protected:
-      // Disable heap allocation
-      static void *operator new (size_t) throw() {return (0);}
-      static void operator delete (void *) throw() {}
+      /**
+       * Poll comparator interrupt status once (PLINT).
+       *
+       * @return true if an unmasked cell is flagged over or under voltage
+       */
+      bool isInterruptPending();
 
-    private:
       /**
-       * Number of LTC6802 configuration registers.
+       * Set number of automatic retries of a read that failed the PEC check.
+       *
+       * @param retries Retries (default 0)
        */
-      static const byte cfgRegisters = 6;
+      void setRetries(byte retries);
 
       /**
-       * Number of LTC6802 temperature registers.
+       * Get number of reads that failed the PEC check.
+       *
+       * @return Error counter, saturates at 255
        */
-      static const byte tmpRegisters = 5;
+      byte getPecErrors() const;
 
       /**
-       * Number of LTC6802 cell registers.
+       * Reset PEC error counter.
        */
-      static const byte cellRegisters = 18;
+      void resetPecErrors();
 
       /**
-       * Number of LTC6802 flag registers.
+       * Write flag register group to serial.
+       *
+       * @Deprecated Don't use anymore
        */
-      static const byte flgRegisters = 3;
+      void flagsDebugOutput();
 
       /**
-       * Number of maximum cells connected to LTC6802.
+       * Encode the register groups into a binary telemetry frame, chip id is the address.
+       *
+       * @param telemetry Telemetry encoder
+       * @param groups Groups to send (LTC6802Telemetry::cfgGroup ...)
+       * @return Frame length
        */
-      static const byte maxCells = 12;
+      byte telemetryEncode(LTC6802Telemetry &telemetry, byte groups) const;
+
+      // bool operator==(const LTC6802& obj1, const LTC6802& obj2);
+      // bool operator!=(const LTC6802& obj1, const LTC6802& obj2);
+
+    protected:
+      // Disable heap allocation
+      static void *operator new (size_t) throw() {return (0);}
+      static void operator delete (void *) throw() {}
+
+    private:
+      /**
+       * Transport the chip is connected to.
+       */
+      LTC6802Transport &bus;
 
       /**
        * Chip SPI address.
@@ -307,19 +654,70 @@
        */
       byte FLG[flgRegisters];
 
+      /**
+       * Pack statistics fed by cellsRead().
+       */
+      LTC6802Stats *stats = 0;
+
+      /**
+       * Automatic retries of reads that failed the PEC check.
+       */
+      byte retries = 0;
+
+      /**
+       * Reads that failed the PEC check.
+       */
+      byte pecErrors = 0;
+
+      /**
+       * Conversion started and not yet reported as finished.
+       */
+      bool converting = false;
+
+      /**
+       * Start time of the last conversion in microseconds.
+       */
+      unsigned long conversionStart = 0;
+
+      /**
+       * Conversion timeout in microseconds.
+       */
+      unsigned long conversionTimeout = 20000;
+
+      /**
+       * Pause between two PLADC polls while blocking, in microseconds.
+       */
+      static const unsigned int pollInterval = 250;
+
 
       // Disable array heap allocation
       static void *operator new[] (size_t);
       static void operator delete[] (void *);
 
       /**
-       * Read registers from chip.
+       * Read registers from chip, retrying on PEC errors.
+       *
+       * The register count follows from the array, so the frame can not overflow.
        *
        * @param cmd Read command.
-       * @param numOfRegisters Number of registers to read
        * @param arr Array for register values
+       * @return ok; pecError
        */
-      void read(byte cmd, byte numOfRegisters, byte * arr);
+      template <byte N> Status read(const byte cmd, byte (&arr)[N])
+       {
+        static_assert(N <= cellRegisters, "Register group larger than the cell voltage group");
+        return readRegisters(cmd, N, arr);
+       }
+
+      /**
+       * Read registers from chip, retrying on PEC errors.
+       *
+       * @param cmd Read command.
+       * @param numOfRegisters Number of registers to read, at most cellRegisters
+       * @param arr Array for register values
+       * @return ok; pecError
+       */
+      Status readRegisters(byte cmd, byte numOfRegisters, byte * arr);
 
       /**
        * Send measure command to chip.
@@ -327,16 +725,27 @@
        * @param cmd Chip command
        * @param broadcast Send as broadcast to multiple chips
        */
-      void measure(byte cmd, bool broadcast) const;
+      void measure(byte cmd, bool broadcast);
+
+      /**
+       * Wait for the running conversion.
+       *
+       * @return ok; timeout when the conversion did not finish
+       */
+      Status waitConversion();
 
       /**
-       * Read register values from chip.
+       * Read register values from chip after the running conversion finished.
        *
        * @param cmd Read command.
-       * @param numOfRegisters Number of registers to read
        * @param arr Array for register values
+       * @return ok; timeout when the conversion did not finish; pecError
        */
-      void readValues(byte cmd, byte numOfRegisters, byte * arr);
+      template <byte N> Status readValues(const byte cmd, byte (&arr)[N])
+       {
+        const Status status = waitConversion();
+        return (status == ok) ? read(cmd, arr) : status;
+       }
 
    };
 
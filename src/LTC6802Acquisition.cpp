@@ -0,0 +1,124 @@
+/**
+ * Copyright 2017, 2019 Dipl.-Inform. Kai Hofmann
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <LTC6802Acquisition.h>
+#include <LTC6802Registers.h>
+
+
+LTC6802Acquisition::LTC6802Acquisition(LTC6802StackBase &stack, LTC6802Snapshot &snapshot)
+ : stack(stack), snapshot(snapshot)
+ {
+ }
+
+
+void LTC6802Acquisition::begin()
+ {
+  end();
+  for (byte chip = 0; chip < stack.getNumChips(); ++chip)
+   {
+    stack.cfg(chip)[0] |= CFG0_LVLPL_MSK;
+   }
+  stack.cfgUpdate();
+  noInterrupts();
+  start();
+  interrupts();
+ }
+
+
+void LTC6802Acquisition::end()
+ {
+  noInterrupts();
+  if (state == waiting)
+   {
+    stack.levelPollEnd();
+   }
+  state = idle;
+  interrupts();
+ }
+
+
+void LTC6802Acquisition::onEdge()
+ {
+  if (state != waiting)
+   {
+    return;
+   }
+  state = reading;
+  stack.levelPollEnd();
+  // SDO also toggles during other traffic, only a finished conversion counts
+  LTC6802::Status status = stack.poll();
+  if (status == LTC6802::busy)
+   {
+    stack.levelPollBegin();
+    state = waiting;
+    return;
+   }
+  if (status == LTC6802::ok)
+   {
+    status = stack.cellsRead();
+   }
+  if (status == LTC6802::ok)
+   {
+    snapshot.publish(stack);
+   }
+  else
+   {
+    ++errors;
+   }
+  start();
+ }
+
+
+bool LTC6802Acquisition::check()
+ {
+  bool restarted = false;
+  noInterrupts();
+  if ((state == waiting) && ((micros() - started) > timeout))
+   {
+    stack.levelPollEnd();
+    ++errors;
+    start();
+    restarted = true;
+   }
+  interrupts();
+  return restarted;
+ }
+
+
+void LTC6802Acquisition::setTimeout(const unsigned long timeout)
+ {
+  this->timeout = timeout;
+ }
+
+
+bool LTC6802Acquisition::isRunning() const
+ {
+  return (state != idle);
+ }
+
+
+unsigned long LTC6802Acquisition::getErrors() const
+ {
+  return errors;
+ }
+
+
+void LTC6802Acquisition::start()
+ {
+  stack.cellsMeasure();
+  started = micros();
+  stack.levelPollBegin();
+  state = waiting;
+ }
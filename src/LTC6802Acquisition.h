@@ -0,0 +1,133 @@
+/**
+ * Copyright 2017, 2019 Dipl.-Inform. Kai Hofmann
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef LTC6802ACQUISITION_H_INCLUDED_
+  #define LTC6802ACQUISITION_H_INCLUDED_
+
+  #include <LTC6802Stack.h>
+  #include <LTC6802Snapshot.h>
+
+  /**
+   * Interrupt driven continuous cell acquisition.
+   *
+   * The chips signal the end of a conversion on SDO (level polling, chip
+   * select held low after PLADC). onEdge(), called from the pin change
+   * interrupt of SDO, reads the results, publishes them to a snapshot and
+   * starts the next conversion, so the main loop never waits for a
+   * conversion and only consumes completed scans from the snapshot.
+   *
+   * While running the acquisition owns the bus and the register frames of
+   * the stack.
+   */
+  class LTC6802Acquisition
+   {
+    public:
+      /**
+       * Constructor.
+       *
+       * @param stack Chips to acquire
+       * @param snapshot Snapshot the scans are published to
+       */
+      LTC6802Acquisition(LTC6802StackBase &stack, LTC6802Snapshot &snapshot);
+
+      /**
+       * Enable level polling in all chips, send the configuration and start the first conversion.
+       */
+      void begin();
+
+      /**
+       * Stop after aborting the running conversion wait and release the bus.
+       */
+      void end();
+
+      /**
+       * Advance the acquisition, to be called from the SDO pin change interrupt (rising edge).
+       *
+       * Edges caused by other bus traffic are detected and ignored.
+       */
+      void onEdge();
+
+      /**
+       * Restart a conversion whose edge never came, to be called from the main loop.
+       *
+       * @return true if the acquisition was restarted
+       */
+      bool check();
+
+      /**
+       * Set the time after which check() restarts a conversion.
+       *
+       * @param timeout Microseconds (default 30000)
+       */
+      void setTimeout(unsigned long timeout);
+
+      /**
+       * Check whether the acquisition is running.
+       *
+       * @return true between begin() and end()
+       */
+      bool isRunning() const;
+
+      /**
+       * Get number of failed reads and restarted conversions.
+       *
+       * @return Error counter
+       */
+      unsigned long getErrors() const;
+
+    private:
+      /**
+       * Acquisition state.
+       */
+      enum State : byte {idle, waiting, reading};
+
+      /**
+       * Chips to acquire.
+       */
+      LTC6802StackBase &stack;
+
+      /**
+       * Snapshot the scans are published to.
+       */
+      LTC6802Snapshot &snapshot;
+
+      /**
+       * Acquisition state.
+       */
+      volatile State state = idle;
+
+      /**
+       * Failed reads and restarted conversions.
+       */
+      volatile unsigned long errors = 0;
+
+      /**
+       * Start time of the running conversion in microseconds.
+       */
+      volatile unsigned long started = 0;
+
+      /**
+       * Restart timeout in microseconds.
+       */
+      unsigned long timeout = 30000;
+
+      /**
+       * Start a conversion and wait for its edge.
+       */
+      void start();
+
+   };
+
+#endif
@@ -0,0 +1,116 @@
+/**
+ * Copyright 2017, 2019 Dipl.-Inform. Kai Hofmann
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <LTC6802Balancer.h>
+#include <LTC6802PEC.h>
+#include <LTC6802Registers.h>
+
+
+LTC6802Balancer::LTC6802Balancer(LTC6802StackBase &stack)
+ : stack(stack)
+ {
+  setThermalLimit(85);
+ }
+
+
+void LTC6802Balancer::setThresholds(const uint16_t start, const uint16_t hysteresis, const uint16_t floor)
+ {
+  this->start = start;
+  this->hysteresis = (hysteresis > start) ? start : hysteresis;
+  this->floor = floor;
+ }
+
+
+void LTC6802Balancer::setThermalLimit(const int celsius)
+ {
+  // itmp * 1.5mV / 8mV per Kelvin
+  thermalLimit = (uint16_t)(((long)celsius + 273) * 16 / 3);
+ }
+
+
+uint16_t LTC6802Balancer::update()
+ {
+  const byte numChips = stack.getNumChips();
+  uint16_t lowest = 0xffff;
+  for (byte chip = 0; chip < numChips; ++chip)
+   {
+    const byte *const cv = stack.cells(chip);
+    const byte cellCount = (stack.cfg(chip)[0] & CFG0_CELL10_MSK) ? 10 : 12;
+    for (byte cell = 0; cell < cellCount; ++cell)
+     {
+      const uint16_t mv = LTC6802::cellDecode(cv, cell, true);
+      // 0 : not measured yet or open input
+      if ((mv != 0) && (mv < lowest))
+       {
+        lowest = mv;
+       }
+     }
+   }
+  if (lowest == 0xffff)
+   {
+    stop();
+    return 0;
+   }
+  const uint16_t startAt = lowest + start;
+  const uint16_t stopAt = lowest + start - hysteresis;
+  balancing = 0;
+  for (byte chip = 0; chip < numChips; ++chip)
+   {
+    byte *const cfg = stack.cfg(chip);
+    const byte *const tmp = stack.temperatures(chip);
+    const word itmp = tmp[3] | ((tmp[4] & 0x0f) << 8);
+    // Fail closed: no discharge without a valid temperature read (never read or failed frames fail the PEC check)
+    const bool thermalValid = LTC6802PEC::check(tmp, LTC6802::tmpRegisters) && (itmp != 0);
+    word dcc = 0;
+    if (thermalValid && ((tmp[4] & 0x10) == 0) && (itmp <= thermalLimit))
+     {
+      const word active = (cfg[1] & CFG1_DCC_MSK) | ((cfg[2] & CFG2_DCC_MSK) << 8);
+      const byte *const cv = stack.cells(chip);
+      const byte cellCount = (cfg[0] & CFG0_CELL10_MSK) ? 10 : 12;
+      for (byte cell = 0; cell < cellCount; ++cell)
+       {
+        const uint16_t mv = LTC6802::cellDecode(cv, cell, true);
+        const word bit = 1 << cell;
+        // Discharging cells continue down to the stop threshold
+        if ((mv > floor) && ((mv > startAt) || ((active & bit) && (mv > stopAt))))
+         {
+          dcc |= bit;
+          ++balancing;
+         }
+       }
+     }
+    cfg[1] = dcc & CFG1_DCC_MSK;
+    cfg[2] = (cfg[2] & CFG2_DCC_INVMSK) | (dcc >> 8);
+   }
+  return balancing;
+ }
+
+
+void LTC6802Balancer::stop()
+ {
+  for (byte chip = 0; chip < stack.getNumChips(); ++chip)
+   {
+    byte *const cfg = stack.cfg(chip);
+    cfg[1] = 0;
+    cfg[2] &= CFG2_DCC_INVMSK;
+   }
+  balancing = 0;
+ }
+
+
+bool LTC6802Balancer::isBalancing() const
+ {
+  return (balancing != 0);
+ }
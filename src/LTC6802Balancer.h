@@ -0,0 +1,116 @@
+/**
+ * Copyright 2017, 2019 Dipl.-Inform. Kai Hofmann
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef LTC6802BALANCER_H_INCLUDED_
+  #define LTC6802BALANCER_H_INCLUDED_
+
+  #include <LTC6802Stack.h>
+
+  /**
+   * Passive cell balancing of a stack.
+   *
+   * Computes the discharge switches (DCC) of all chips from the last cell
+   * and temperature reads and stores them into the stack configuration, so
+   * they go out with the next cfgUpdate()/keepAlive() instead of extra
+   * writes. Measure with cellsMeasure(isBalancing()) to keep the switches
+   * on during conversions.
+   */
+  class LTC6802Balancer
+   {
+    public:
+      /**
+       * Constructor.
+       *
+       * @param stack Chips to balance
+       */
+      explicit LTC6802Balancer(LTC6802StackBase &stack);
+
+      /**
+       * Set balancing thresholds.
+       *
+       * A cell starts discharging when it is more than start above the
+       * lowest cell of the stack and stops when it is less than
+       * start - hysteresis above it. Cells at or below floor never discharge.
+       *
+       * @param start Voltage above the lowest cell in mV (default 10)
+       * @param hysteresis Voltage in mV (default 5)
+       * @param floor Voltage in mV (default 3000)
+       */
+      void setThresholds(uint16_t start, uint16_t hysteresis, uint16_t floor);
+
+      /**
+       * Set die temperature above which a chip stops discharging.
+       *
+       * Chips reporting a thermal shutdown never discharge, neither do chips
+       * without a valid temperatureRead() (not read yet, PEC error, die
+       * temperature 0).
+       *
+       * @param celsius Temperature in degree celsius (default 85)
+       */
+      void setThermalLimit(int celsius);
+
+      /**
+       * Compute discharge switches from the last cellsRead() and temperatureRead().
+       *
+       * @return Number of discharging cells
+       */
+      uint16_t update();
+
+      /**
+       * Switch all discharging off.
+       */
+      void stop();
+
+      /**
+       * Check for discharging cells.
+       *
+       * @return true if any discharge switch is on
+       */
+      bool isBalancing() const;
+
+    private:
+      /**
+       * Chips to balance.
+       */
+      LTC6802StackBase &stack;
+
+      /**
+       * Start threshold above the lowest cell in mV.
+       */
+      uint16_t start = 10;
+
+      /**
+       * Stop hysteresis in mV.
+       */
+      uint16_t hysteresis = 5;
+
+      /**
+       * Lowest voltage to discharge in mV.
+       */
+      uint16_t floor = 3000;
+
+      /**
+       * Die temperature limit as ITMP code.
+       */
+      uint16_t thermalLimit;
+
+      /**
+       * Discharging cells after the last update.
+       */
+      uint16_t balancing = 0;
+
+   };
+
+#endif
@@ -0,0 +1,112 @@
+/**
+ * Copyright 2017, 2019 Dipl.-Inform. Kai Hofmann
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <LTC6802CellScheduler.h>
+
+
+LTC6802CellScheduler::LTC6802CellScheduler(LTC6802StackBase &stack, uint16_t *const millivolts, const byte fastPerScan)
+ : stack(stack), millivolts(millivolts), fastPerScan(fastPerScan), slot(fastPerScan)
+ {
+ }
+
+
+void LTC6802CellScheduler::watch(const uint16_t cells)
+ {
+  // Inputs above the cells per chip are not connected in 10 cell mode
+  manual = cells & ((1U << stack.getCellsPerChip()) - 1);
+ }
+
+
+void LTC6802CellScheduler::setHotThresholds(const uint16_t high, const uint16_t low)
+ {
+  this->high = high;
+  this->low = low;
+  if ((high == 0) && (low == 0))
+   {
+    hot = 0;
+   }
+ }
+
+
+uint16_t LTC6802CellScheduler::getWatched() const
+ {
+  return manual | hot;
+ }
+
+
+LTC6802::Status LTC6802CellScheduler::step()
+ {
+  const uint16_t watched = manual | hot;
+  LTC6802::Status status;
+  if ((slot < fastPerScan) && (watched != 0))
+   {
+    do
+     {
+      cell = (cell + 1 < stack.getCellsPerChip()) ? (cell + 1) : 0;
+     }
+    while ((watched & (1 << cell)) == 0);
+    stack.cellMeasure(cell);
+    status = stack.cellRead(cell, millivolts);
+    ++slot;
+    full = false;
+   }
+  else
+   {
+    stack.cellsMeasure();
+    status = stack.cellsRead();
+    if (status == LTC6802::ok)
+     {
+      stack.cellsGetMillivolts(millivolts);
+      updateHot();
+     }
+    slot = 0;
+    full = true;
+   }
+  return status;
+ }
+
+
+bool LTC6802CellScheduler::wasFullScan() const
+ {
+  return full;
+ }
+
+
+byte LTC6802CellScheduler::getLastCell() const
+ {
+  return cell;
+ }
+
+
+void LTC6802CellScheduler::updateHot()
+ {
+  hot = 0;
+  if ((high == 0) && (low == 0))
+   {
+    return;
+   }
+  const byte cellsPerChip = stack.getCellsPerChip();
+  for (byte chip = 0; chip < stack.getNumChips(); ++chip)
+   {
+    const uint16_t *const mv = &millivolts[chip * LTC6802::maxCells];
+    for (byte i = 0; i < cellsPerChip; ++i)
+     {
+      if (((high != 0) && (mv[i] >= high)) || ((low != 0) && (mv[i] != 0) && (mv[i] <= low)))
+       {
+        hot |= 1 << i;
+       }
+     }
+   }
+ }
@@ -0,0 +1,141 @@
+/**
+ * Copyright 2017, 2019 Dipl.-Inform. Kai Hofmann
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef LTC6802CELLSCHEDULER_H_INCLUDED_
+  #define LTC6802CELLSCHEDULER_H_INCLUDED_
+
+  #include <LTC6802Stack.h>
+
+  /**
+   * Interleaves fast single cell samples between full cell scans.
+   *
+   * Watched cells (the same cell index on all chips, as conversions are
+   * broadcast) are sampled round robin in the slots between two full scans.
+   * Cells near a limit can be watched automatically after every full scan.
+   */
+  class LTC6802CellScheduler
+   {
+    public:
+      /**
+       * Constructor.
+       *
+       * @param stack Chips to sample
+       * @param millivolts Array for numChips * 12 voltages in mV, chip 0 first; kept up to date by step()
+       * @param fastPerScan Fast samples between two full scans
+       */
+      LTC6802CellScheduler(LTC6802StackBase &stack, uint16_t *millivolts, byte fastPerScan = 4);
+
+      /**
+       * Set manually watched cells.
+       *
+       * @param cells Bit i set : sample cell index i of all chips, bits from getCellsPerChip() on are ignored
+       */
+      void watch(uint16_t cells);
+
+      /**
+       * Watch cells automatically after every full scan.
+       *
+       * @param high Watch cells at or above this voltage in mV, 0 : off
+       * @param low Watch cells at or below this voltage in mV, 0 : off; cells reading 0 (unused in 10 cell mode) are skipped
+       */
+      void setHotThresholds(uint16_t high, uint16_t low = 0);
+
+      /**
+       * Get watched cells, manual and automatic.
+       *
+       * @return Bit i set : cell index i is sampled
+       */
+      uint16_t getWatched() const;
+
+      /**
+       * Run the next slot, a fast sample or a full scan.
+       *
+       * @return Status of the read
+       */
+      LTC6802::Status step();
+
+      /**
+       * Check whether the last slot was a full scan.
+       *
+       * @return true : full scan; false : fast sample
+       */
+      bool wasFullScan() const;
+
+      /**
+       * Get cell index sampled in the last fast slot.
+       *
+       * @return Cell index 0-11
+       */
+      byte getLastCell() const;
+
+    private:
+      /**
+       * Chips to sample.
+       */
+      LTC6802StackBase &stack;
+
+      /**
+       * Latest cell voltages in mV.
+       */
+      uint16_t *millivolts;
+
+      /**
+       * Fast samples between two full scans.
+       */
+      byte fastPerScan;
+
+      /**
+       * Fast samples since the last full scan.
+       */
+      byte slot;
+
+      /**
+       * Cell sampled last.
+       */
+      byte cell = LTC6802::maxCells - 1;
+
+      /**
+       * Last slot was a full scan.
+       */
+      bool full = false;
+
+      /**
+       * Manually watched cells.
+       */
+      uint16_t manual = 0;
+
+      /**
+       * Automatically watched cells.
+       */
+      uint16_t hot = 0;
+
+      /**
+       * Upper watch threshold in mV.
+       */
+      uint16_t high = 0;
+
+      /**
+       * Lower watch threshold in mV.
+       */
+      uint16_t low = 0;
+
+      /**
+       * Watch cells near a limit after a full scan.
+       */
+      void updateHot();
+
+   };
+
+#endif
@@ -0,0 +1,106 @@
+/**
+ * Copyright 2017, 2019 Dipl.-Inform. Kai Hofmann
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <LTC6802Monitor.h>
+#include <LTC6802Registers.h>
+
+
+LTC6802Monitor::LTC6802Monitor(LTC6802StackBase &stack)
+ : stack(stack)
+ {
+ }
+
+
+void LTC6802Monitor::begin(const word undervoltage, const word overvoltage, const byte cdc)
+ {
+  // Cells 11 and 12 are not connected in 10 cell mode
+  const word mci = (stack.getCellsPerChip() < LTC6802::maxCells) ? 0x0c00 : 0x0000;
+  for (byte chip = 0; chip < stack.getNumChips(); ++chip)
+   {
+    byte *const cfg = stack.cfg(chip);
+    cfg[0] = (cfg[0] & CFG0_CDC_INVMSK) | (cdc & CFG0_CDC_MSK);
+    cfg[2] = (cfg[2] & CFG2_MCI_INVMSK) | ((mci & 0x0f) << 4);
+    cfg[3] = mci >> 4;
+    cfg[4] = LTC6802::undervoltageEncode(undervoltage);
+    cfg[5] = LTC6802::overvoltageEncode(overvoltage);
+   }
+  stack.setConversionTimeout((cdc >= 5) ? 30000 : 20000);
+  stack.cfgUpdate();
+  initial = true;
+ }
+
+
+void LTC6802Monitor::setScanInterval(const unsigned long interval)
+ {
+  scanInterval = interval;
+ }
+
+
+LTC6802Monitor::Event LTC6802Monitor::step()
+ {
+  return step(stack.isInterruptPending());
+ }
+
+
+LTC6802Monitor::Event LTC6802Monitor::step(const bool interrupt)
+ {
+  // Restores CDC and thresholds of chips that lost their configuration
+  stack.keepAlive();
+  const bool due = initial || ((scanInterval != 0) && ((millis() - lastScan) >= scanInterval));
+  if (!interrupt && !due)
+   {
+    return none;
+   }
+  status = scan();
+  return (interrupt || fault) ? faultScan : periodicScan;
+ }
+
+
+LTC6802::Status LTC6802Monitor::getStatus() const
+ {
+  return status;
+ }
+
+
+bool LTC6802Monitor::hasFault() const
+ {
+  return fault;
+ }
+
+
+LTC6802::Status LTC6802Monitor::scan()
+ {
+  lastScan = millis();
+  initial = false;
+  stack.cellsMeasure();
+  LTC6802::Status result = stack.cellsRead();
+  const LTC6802::Status flagStatus = stack.flagsRead();
+  if (result == LTC6802::ok)
+   {
+    result = flagStatus;
+   }
+  fault = false;
+  if (flagStatus == LTC6802::ok)
+   {
+    for (byte chip = 0; chip < stack.getNumChips(); ++chip)
+     {
+      word overvoltage;
+      word undervoltage;
+      stack.flagsGet(chip, overvoltage, undervoltage);
+      fault = fault || (overvoltage != 0) || (undervoltage != 0);
+     }
+   }
+  return result;
+ }
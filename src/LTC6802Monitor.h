@@ -0,0 +1,132 @@
+/**
+ * Copyright 2017, 2019 Dipl.-Inform. Kai Hofmann
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef LTC6802MONITOR_H_INCLUDED_
+  #define LTC6802MONITOR_H_INCLUDED_
+
+  #include <LTC6802Stack.h>
+
+  /**
+   * Pack supervision by the on chip over/under voltage comparators.
+   *
+   * The chips compare all cells against VUV/VOV on their own (CDC 2-7),
+   * the monitor only polls the interrupt status (PLINT, 2 bytes) or takes
+   * the state of an interrupt line and performs a full cell and flag scan
+   * when a flag trips or the slow periodic scan is due.
+   */
+  class LTC6802Monitor
+   {
+    public:
+      /**
+       * Outcome of a step.
+       */
+      enum Event : byte {none, periodicScan, faultScan};
+
+      /**
+       * Constructor.
+       *
+       * @param stack Chips to supervise
+       */
+      explicit LTC6802Monitor(LTC6802StackBase &stack);
+
+      /**
+       * Configure comparators of all chips and send the configuration.
+       *
+       * Unused cells in 10 cell mode are masked. The conversion timeout of the
+       * stack is raised for the slower measurements of CDC 5-7.
+       *
+       * @param undervoltage Threshold in mV, 0 : off
+       * @param overvoltage Threshold in mV, 0 : off
+       * @param cdc Comparator duty cycle 2-7 (3 : every 130ms)
+       */
+      void begin(word undervoltage, word overvoltage, byte cdc = 3);
+
+      /**
+       * Set interval of the periodic full scan.
+       *
+       * @param interval Milliseconds (default 10000), 0 : scan only on flags
+       */
+      void setScanInterval(unsigned long interval);
+
+      /**
+       * Keep the chips alive, poll the interrupt status and scan if needed.
+       *
+       * @return Scan performed
+       */
+      Event step();
+
+      /**
+       * Keep the chips alive and scan if needed, interrupt status supplied by the caller.
+       *
+       * @param interrupt Interrupt line or flag set by an interrupt handler
+       * @return Scan performed
+       */
+      Event step(bool interrupt);
+
+      /**
+       * Get status of the last scan.
+       *
+       * @return ok; timeout; pecError
+       */
+      LTC6802::Status getStatus() const;
+
+      /**
+       * Check comparator flags of the last scan.
+       *
+       * @return true if any cell was flagged over or under voltage
+       */
+      bool hasFault() const;
+
+    private:
+      /**
+       * Chips to supervise.
+       */
+      LTC6802StackBase &stack;
+
+      /**
+       * Periodic scan interval in milliseconds.
+       */
+      unsigned long scanInterval = 10000;
+
+      /**
+       * Time of the last scan in milliseconds.
+       */
+      unsigned long lastScan = 0;
+
+      /**
+       * Status of the last scan.
+       */
+      LTC6802::Status status = LTC6802::ok;
+
+      /**
+       * Flags of the last scan.
+       */
+      bool fault = false;
+
+      /**
+       * First scan still to do.
+       */
+      bool initial = true;
+
+      /**
+       * Read cells and flags of all chips.
+       *
+       * @return Status of the reads
+       */
+      LTC6802::Status scan();
+
+   };
+
+#endif
@@ -0,0 +1,88 @@
+/**
+ * Copyright 2017, 2019 Dipl.-Inform. Kai Hofmann
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <LTC6802MultiStack.h>
+
+
+LTC6802MultiStack::LTC6802MultiStack(LTC6802StackBase *const *const stacks, const byte numStacks)
+ : stacks(stacks), numStacks(numStacks)
+ {
+ }
+
+
+void LTC6802MultiStack::begin()
+ {
+  for (byte i = 0; i < numStacks; ++i)
+   {
+    stacks[i]->cellsMeasure();
+   }
+  next = 0;
+  rounds = 0;
+ }
+
+
+LTC6802::Status LTC6802MultiStack::step()
+ {
+  LTC6802StackBase &stack = *stacks[next];
+  LTC6802::Status status = stack.poll();
+  if (status == LTC6802::busy)
+   {
+    return status;
+   }
+  if (status == LTC6802::ok)
+   {
+    status = stack.cellsRead();
+   }
+  // Converts while the other stacks are read
+  stack.cellsMeasure();
+  last = next;
+  if (++next == numStacks)
+   {
+    next = 0;
+    ++rounds;
+   }
+  return status;
+ }
+
+
+LTC6802::Status LTC6802MultiStack::scan()
+ {
+  LTC6802::Status result = LTC6802::ok;
+  for (byte read = 0; read < numStacks; ++read)
+   {
+    LTC6802::Status status;
+    while ((status = step()) == LTC6802::busy)
+     {
+      delayMicroseconds(pollInterval);
+     }
+    if (status != LTC6802::ok)
+     {
+      result = status;
+     }
+   }
+  return result;
+ }
+
+
+byte LTC6802MultiStack::getLastStack() const
+ {
+  return last;
+ }
+
+
+unsigned long LTC6802MultiStack::getRounds() const
+ {
+  return rounds;
+ }
@@ -0,0 +1,111 @@
+/**
+ * Copyright 2017, 2019 Dipl.-Inform. Kai Hofmann
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef LTC6802MULTISTACK_H_INCLUDED_
+  #define LTC6802MULTISTACK_H_INCLUDED_
+
+  #include <LTC6802Stack.h>
+
+  /**
+   * Overlapped cell acquisition of several independent stacks.
+   *
+   * Stacks on separate buses or chip selects convert in parallel: every
+   * stack gets its next conversion started right after its results were
+   * read, so while one stack is read the others keep converting and a
+   * round over all stacks tends toward the pure bus transfer time instead
+   * of the sum of the conversion times.
+   *
+   * Stacks must not share chips (same bus and chip select).
+   */
+  class LTC6802MultiStack
+   {
+    public:
+      /**
+       * Constructor.
+       *
+       * @param stacks Stacks, read round robin in this order
+       * @param numStacks Number of stacks
+       */
+      LTC6802MultiStack(LTC6802StackBase *const *stacks, byte numStacks);
+
+      /**
+       * Start cell conversions on all stacks.
+       */
+      void begin();
+
+      /**
+       * Read the next stack if its conversion is done and start its next conversion.
+       *
+       * Never waits for a conversion.
+       *
+       * @return busy : next stack still converting, nothing read; otherwise status of the read
+       */
+      LTC6802::Status step();
+
+      /**
+       * Read every stack once, waiting for conversions still running.
+       *
+       * @return ok if all reads succeeded; otherwise the last error
+       */
+      LTC6802::Status scan();
+
+      /**
+       * Get stack read by the last step.
+       *
+       * @return Index into the stacks
+       */
+      byte getLastStack() const;
+
+      /**
+       * Get completed rounds over all stacks.
+       *
+       * @return Rounds since begin()
+       */
+      unsigned long getRounds() const;
+
+    private:
+      /**
+       * Pause between two PLADC polls while blocking in scan(), in microseconds.
+       */
+      static const unsigned int pollInterval = 250;
+
+      /**
+       * Stacks in read order.
+       */
+      LTC6802StackBase *const *stacks;
+
+      /**
+       * Number of stacks.
+       */
+      byte numStacks;
+
+      /**
+       * Stack to read next.
+       */
+      byte next = 0;
+
+      /**
+       * Stack read last.
+       */
+      byte last = 0;
+
+      /**
+       * Completed rounds.
+       */
+      unsigned long rounds = 0;
+
+   };
+
+#endif
@@ -0,0 +1,120 @@
+/**
+ * Copyright 2017, 2019 Dipl.-Inform. Kai Hofmann
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <LTC6802OpenWire.h>
+#include <LTC6802Registers.h>
+
+
+LTC6802OpenWire::LTC6802OpenWire(LTC6802StackBase &stack, uint16_t *const codes, uint16_t *const suspects)
+ : stack(stack), codes(codes), suspects(suspects)
+ {
+  for (byte chip = 0; chip < stack.getNumChips(); ++chip)
+   {
+    suspects[chip] = 0;
+   }
+ }
+
+
+void LTC6802OpenWire::setThresholds(const uint16_t delta, const uint16_t floor)
+ {
+  // mV / 1.5 rounded
+  this->delta = (uint16_t)(((uint32_t)delta * 2 + 1) / 3);
+  this->floor = (uint16_t)(((uint32_t)floor * 2 + 1) / 3);
+ }
+
+
+void LTC6802OpenWire::start(const bool discharge)
+ {
+  this->discharge = discharge;
+  phase = openWireStart;
+ }
+
+
+LTC6802::Status LTC6802OpenWire::step()
+ {
+  LTC6802::Status status;
+  switch (phase)
+   {
+    case openWireStart:
+      stack.openWireMeasure(discharge);
+      phase = openWireWait;
+      return LTC6802::busy;
+    case openWireWait:
+      if ((status = stack.poll()) == LTC6802::busy)
+       {
+        return status;
+       }
+      if ((status == LTC6802::ok) && ((status = stack.openWireRead(codes)) == LTC6802::ok))
+       {
+        stack.cellsMeasure();
+        phase = normalWait;
+        return LTC6802::busy;
+       }
+      break;
+    case normalWait:
+      if ((status = stack.poll()) == LTC6802::busy)
+       {
+        return status;
+       }
+      if ((status == LTC6802::ok) && ((status = stack.cellsRead()) == LTC6802::ok))
+       {
+        evaluate();
+       }
+      break;
+    default:
+      return LTC6802::ok;
+   }
+  phase = idle;
+  return status;
+ }
+
+
+bool LTC6802OpenWire::isRunning() const
+ {
+  return (phase != idle);
+ }
+
+
+uint16_t LTC6802OpenWire::getSuspects(const byte chip) const
+ {
+  return suspects[chip];
+ }
+
+
+void LTC6802OpenWire::evaluate()
+ {
+  for (byte chip = 0; chip < stack.getNumChips(); ++chip)
+   {
+    const byte *const cv = stack.cells(chip);
+    const uint16_t *const ow = &codes[chip * LTC6802::maxCells];
+    const byte top = (stack.cfg(chip)[0] & CFG0_CELL10_MSK) ? 10 : 12;
+    uint16_t bits = 0;
+    for (byte n = 1; n < top; ++n)
+     {
+      // Input Cn between cell n (index n - 1) and cell n + 1 (index n)
+      const uint16_t below = LTC6802::cellDecode(cv, n - 1, false);
+      const uint16_t above = LTC6802::cellDecode(cv, n, false);
+      if ((ow[n] > above + delta) || ((ow[n - 1] + delta < below) && (ow[n - 1] < floor)))
+       {
+        bits |= 1 << n;
+       }
+     }
+    if (ow[top - 1] < floor)
+     {
+      bits |= 1 << top;
+     }
+    suspects[chip] = bits;
+   }
+ }
@@ -0,0 +1,132 @@
+/**
+ * Copyright 2017, 2019 Dipl.-Inform. Kai Hofmann
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef LTC6802OPENWIRE_H_INCLUDED_
+  #define LTC6802OPENWIRE_H_INCLUDED_
+
+  #include <LTC6802Stack.h>
+
+  /**
+   * Incremental open-wire diagnosis of all cell inputs of a stack.
+   *
+   * Runs an open-wire conversion (STOWAD/STOWDC) followed by a normal cell
+   * conversion and compares both per cell. Every step() does at most one
+   * bus action and never waits for a conversion, so the diagnosis spreads
+   * over several main loop cycles. The final normal conversion is a regular
+   * cellsRead() and leaves valid cell voltages in the stack. No other
+   * conversion may be started on the stack while the diagnosis runs.
+   */
+  class LTC6802OpenWire
+   {
+    public:
+      /**
+       * Constructor.
+       *
+       * @param stack Chips to diagnose
+       * @param codes Array for numChips * 12 open-wire codes, chip 0 first
+       * @param suspects Array for numChips bitmaps, bit n : input Cn (1-12) suspect
+       */
+      LTC6802OpenWire(LTC6802StackBase &stack, uint16_t *codes, uint16_t *suspects);
+
+      /**
+       * Set detection thresholds.
+       *
+       * Input Cn is suspect when cell n+1 reads more than delta above its
+       * normal voltage or cell n drops more than delta and reads below floor.
+       * C12 (C10 in 10 cell mode) is suspect when the top cell reads below floor.
+       *
+       * @param delta Voltage difference in mV (default 200)
+       * @param floor Voltage of a pulled down cell in mV (default 100)
+       */
+      void setThresholds(uint16_t delta, uint16_t floor);
+
+      /**
+       * Start a new diagnosis.
+       *
+       * @param discharge true : discharge permitted (STOWDC); false : discharge off during conversion (STOWAD)
+       */
+      void start(bool discharge = false);
+
+      /**
+       * Advance the running diagnosis.
+       *
+       * @return busy while running; ok when finished (also when not started); timeout or pecError aborts the diagnosis
+       */
+      LTC6802::Status step();
+
+      /**
+       * Check for running diagnosis.
+       *
+       * @return true while step() has to be called
+       */
+      bool isRunning() const;
+
+      /**
+       * Get suspect inputs of a chip from the last finished diagnosis.
+       *
+       * @param chip Chip index, 0 : bottom chip
+       * @return Bit n : input Cn (1-12) suspect
+       */
+      uint16_t getSuspects(byte chip) const;
+
+    private:
+      /**
+       * Diagnosis phases.
+       */
+      enum Phase {idle, openWireStart, openWireWait, normalWait};
+
+      /**
+       * Chips to diagnose.
+       */
+      LTC6802StackBase &stack;
+
+      /**
+       * Open-wire codes of all cells.
+       */
+      uint16_t *codes;
+
+      /**
+       * Suspect input bitmaps of all chips.
+       */
+      uint16_t *suspects;
+
+      /**
+       * Difference threshold in A/D codes.
+       */
+      uint16_t delta = 133;
+
+      /**
+       * Pulled down threshold in A/D codes.
+       */
+      uint16_t floor = 67;
+
+      /**
+       * Current phase.
+       */
+      Phase phase = idle;
+
+      /**
+       * Open-wire conversion with discharge permitted.
+       */
+      bool discharge = false;
+
+      /**
+       * Compare open-wire and normal codes of all chips.
+       */
+      void evaluate();
+
+   };
+
+#endif
@@ -0,0 +1,73 @@
+/**
+ * Copyright 2017, 2019 Dipl.-Inform. Kai Hofmann
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <LTC6802PEC.h>
+
+
+/**
+ * CRC-8 polynomial x^8 + x^2 + x + 1.
+ */
+static const byte polynomial = 0x07;
+
+/**
+ * Shift bits through the CRC register (C++11 constexpr recursion).
+ *
+ * @param crc CRC register
+ * @param bits Bits left to shift
+ * @return CRC register after shifting
+ */
+static constexpr byte pecShift(const byte crc, const int bits)
+ {
+  return (bits == 0) ? crc : pecShift((crc & 0x80) ? (byte)((crc << 1) ^ polynomial) : (byte)(crc << 1), bits - 1);
+ }
+
+/**
+ * Compile time index list 0..N-1.
+ */
+template <unsigned int... Is> struct PECIndices {};
+
+template <unsigned int N, unsigned int... Is> struct PECMakeIndices : PECMakeIndices<N - 1, N - 1, Is...> {};
+
+template <unsigned int... Is> struct PECMakeIndices<0, Is...>
+ {
+  typedef PECIndices<Is...> type;
+ };
+
+/**
+ * PEC lookup table, one entry per byte value.
+ */
+template <typename Indices> struct PECTable;
+
+template <unsigned int... Is> struct PECTable<PECIndices<Is...> >
+ {
+  static const byte values[sizeof...(Is)];
+ };
+
+template <unsigned int... Is> const byte PECTable<PECIndices<Is...> >::values[sizeof...(Is)] PROGMEM = {pecShift((byte)Is, 8)...};
+
+/**
+ * Table instance.
+ */
+typedef PECTable<PECMakeIndices<256>::type> Table;
+
+
+byte LTC6802PEC::update(byte pec, const byte *const data, const byte len)
+ {
+  for (int i = 0; i < len; ++i)
+   {
+    pec = pgm_read_byte(&Table::values[pec ^ data[i]]);
+   }
+  return pec;
+ }
@@ -0,0 +1,65 @@
+/**
+ * Copyright 2017, 2019 Dipl.-Inform. Kai Hofmann
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef LTC6802PEC_H_INCLUDED_
+  #define LTC6802PEC_H_INCLUDED_
+
+  #include <LTC6802Platform.h>
+
+  /**
+   * LTC6802 packet error code (CRC-8, x^8 + x^2 + x + 1, initial value 0x41).
+   *
+   * Table driven; the 256 entry table is generated at compile time and
+   * kept in flash (PROGMEM) on AVR.
+   */
+  class LTC6802PEC
+   {
+    public:
+      /**
+       * Initial PEC value.
+       */
+      static const byte init = 0x41;
+
+      /**
+       * Continue a PEC calculation.
+       *
+       * @param pec PEC of the preceding bytes (init for none)
+       * @param data Bytes
+       * @param len Number of bytes
+       * @return PEC
+       */
+      static byte update(byte pec, const byte *data, byte len);
+
+      /**
+       * Calculate PEC of bytes.
+       *
+       * @param data Bytes
+       * @param len Number of bytes
+       * @return PEC
+       */
+      static byte calculate(const byte *data, byte len) {return (update(init, data, len));}
+
+      /**
+       * Check register bytes followed by their PEC.
+       *
+       * @param data Bytes, data[len] is the received PEC
+       * @param len Number of register bytes
+       * @return true if the PEC matches
+       */
+      static bool check(const byte *data, byte len) {return (calculate(data, len) == data[len]);}
+
+   };
+
+#endif
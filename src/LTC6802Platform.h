@@ -0,0 +1,170 @@
+/**
+ * Copyright 2017, 2019 Dipl.-Inform. Kai Hofmann
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef LTC6802PLATFORM_H_INCLUDED_
+  #define LTC6802PLATFORM_H_INCLUDED_
+
+  #ifdef ARDUINO
+
+    #include <Arduino.h>
+
+  #else
+
+    /*
+     * Minimal Arduino core replacement for host builds (simulator, benchmarks).
+     *
+     * Time is virtual: it only advances when a host transport clocks bytes or
+     * when delay()/delayMicroseconds() are called, so host runs are repeatable
+     * and report modeled bus time instead of host scheduling noise.
+     *
+     * Define LTC6802_REALTIME when driving real chips from Linux (see
+     * LTC6802SpidevTransport): time then follows CLOCK_MONOTONIC and the
+     * delays sleep.
+     */
+
+    #include <stdint.h>
+    #include <stddef.h>
+    #include <stdio.h>
+    #ifdef LTC6802_REALTIME
+      #include <time.h>
+    #endif
+
+    typedef uint8_t byte;
+    typedef uint16_t word;
+
+    #define LOW  0
+    #define HIGH 1
+
+    #define INPUT  0
+    #define OUTPUT 1
+
+    #define BIN 2
+    #define OCT 8
+    #define DEC 10
+    #define HEX 16
+
+    #define PROGMEM
+    #define pgm_read_byte(addr) (*(const byte *)(addr))
+    #define pgm_read_word(addr) (*(const word *)(addr))
+
+    /**
+     * Virtual host clock in nanoseconds.
+     */
+    class LTC6802HostClock
+     {
+      public:
+    #ifdef LTC6802_REALTIME
+        /**
+         * Get current monotonic time.
+         *
+         * @return Nanoseconds since an arbitrary start
+         */
+        static uint64_t nanos()
+         {
+          struct timespec ts;
+          clock_gettime(CLOCK_MONOTONIC, &ts);
+          return (uint64_t)ts.tv_sec * 1000000000U + (uint64_t)ts.tv_nsec;
+         }
+
+        /**
+         * Sleep.
+         *
+         * @param ns Nanoseconds to sleep
+         */
+        static void advance(const uint64_t ns)
+         {
+          const struct timespec ts = {(time_t)(ns / 1000000000U), (long)(ns % 1000000000U)};
+          nanosleep(&ts, 0);
+         }
+    #else
+        /**
+         * Get current virtual time.
+         *
+         * @return Nanoseconds since start
+         */
+        static uint64_t nanos() {return (now);}
+
+        /**
+         * Advance virtual time.
+         *
+         * @param ns Nanoseconds to advance
+         */
+        static void advance(const uint64_t ns) {now += ns;}
+    #endif
+
+      private:
+        /**
+         * Current virtual time in nanoseconds.
+         */
+        static inline uint64_t now = 0;
+     };
+
+    inline unsigned long micros() {return (unsigned long)(LTC6802HostClock::nanos() / 1000);}
+    inline unsigned long millis() {return (unsigned long)(LTC6802HostClock::nanos() / 1000000);}
+    inline void delay(const unsigned long ms) {LTC6802HostClock::advance((uint64_t)ms * 1000000);}
+    inline void delayMicroseconds(const unsigned int us) {LTC6802HostClock::advance((uint64_t)us * 1000);}
+    inline void pinMode(byte, byte) {}
+    inline void digitalWrite(byte, byte) {}
+    inline int digitalRead(byte) {return (HIGH);}
+    inline void noInterrupts() {}
+    inline void interrupts() {}
+
+    /**
+     * Serial replacement writing to stdout.
+     */
+    class LTC6802HostSerial
+     {
+      public:
+        void begin(unsigned long) {}
+        size_t write(const byte *buf, size_t len) {return fwrite(buf, 1, len, stdout);}
+        void print(const char *str) {fputs(str, stdout);}
+        void print(char c) {fputc(c, stdout);}
+        void print(unsigned char n, int base = DEC) {print((unsigned long)n, base);}
+        void print(int n, int base = DEC) {print((long)n, base);}
+        void print(unsigned int n, int base = DEC) {print((unsigned long)n, base);}
+        void print(long n, int base = DEC)
+         {
+          if ((base == DEC) && (n < 0))
+           {
+            fputc('-', stdout);
+            n = -n;
+           }
+          print((unsigned long)n, base);
+         }
+        void print(unsigned long n, int base = DEC)
+         {
+          char buf[8 * sizeof(long) + 1];
+          char *str = &buf[sizeof(buf) - 1];
+          *str = '\0';
+          do
+           {
+            const unsigned long digit = n % base;
+            n /= base;
+            *--str = (char)((digit < 10) ? ('0' + digit) : ('A' + digit - 10));
+           }
+          while (n != 0);
+          fputs(str, stdout);
+         }
+        void print(double n, int digits = 2) {printf("%.*f", digits, n);}
+        void println() {fputs("\r\n", stdout);}
+        template <typename T> void println(T value) {print(value); println();}
+        template <typename T> void println(T value, int format) {print(value, format); println();}
+     };
+
+    inline LTC6802HostSerial Serial;
+
+  #endif
+
+#endif
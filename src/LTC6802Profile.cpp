@@ -0,0 +1,84 @@
+/**
+ * Copyright 2017, 2019 Dipl.-Inform. Kai Hofmann
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <LTC6802Profile.h>
+
+#ifdef LTC6802_PROFILE
+
+
+LTC6802Profile::Report LTC6802Profile::report;
+
+
+void LTC6802Profile::record(const Operation operation, const unsigned long duration)
+ {
+  Timing &timing = report.timings[operation];
+  if ((timing.calls == 0) || (duration < timing.min))
+   {
+    timing.min = duration;
+   }
+  if (duration > timing.max)
+   {
+    timing.max = duration;
+   }
+  ++timing.calls;
+  timing.total += duration;
+ }
+
+
+unsigned long LTC6802Profile::getMean(const Operation operation)
+ {
+  const Timing &timing = report.timings[operation];
+  return (timing.calls == 0) ? 0 : (timing.total / timing.calls);
+ }
+
+
+void LTC6802Profile::reset()
+ {
+  report = Report();
+ }
+
+
+void LTC6802Profile::debugOutput()
+ {
+  static const char *const names[operations] =
+   {
+    "cfgWrite", "cfgRead", "cellsMeasure", "cellsRead", "temperatureMeasure", "temperatureRead", "flagsRead",
+    "stack.cfgWrite", "stack.cfgUpdate", "stack.keepAlive", "stack.cfgRead", "stack.cellsMeasure", "stack.cellsRead",
+    "stack.temperatureMeasure", "stack.temperatureRead", "stack.flagsRead", "stack.scanRead", "scanPeriod"
+   };
+  for (byte op = 0; op < operations; ++op)
+   {
+    const Timing &timing = report.timings[op];
+    if (timing.calls == 0)
+     {
+      continue;
+     }
+    Serial.print(names[op]);
+    Serial.print(" ");
+    Serial.print(timing.calls);
+    Serial.print(" ");
+    Serial.print(timing.min);
+    Serial.print(" ");
+    Serial.print(getMean((Operation)op));
+    Serial.print(" ");
+    Serial.println(timing.max);
+   }
+  Serial.print("retries ");
+  Serial.print(report.retries);
+  Serial.print(" polls ");
+  Serial.println(report.polls);
+ }
+
+#endif
@@ -0,0 +1,164 @@
+/**
+ * Copyright 2017, 2019 Dipl.-Inform. Kai Hofmann
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef LTC6802PROFILE_H_INCLUDED_
+  #define LTC6802PROFILE_H_INCLUDED_
+
+  #include <LTC6802Platform.h>
+
+  /**
+   * Optional hot path instrumentation.
+   *
+   * Build the library with LTC6802_PROFILE defined to record call counts and
+   * min/max/mean micros() durations of the driver operations as well as PEC
+   * retries and conversion polls. Without it the hooks expand to nothing and
+   * no RAM is reserved.
+   */
+  class LTC6802Profile
+   {
+    public:
+      /**
+       * Profiled operations, scanPeriod : one cycle of a LTC6802ScanPipeline plan.
+       */
+      enum Operation : byte
+       {
+        cfgWrite, cfgRead, cellsMeasure, cellsRead, temperatureMeasure, temperatureRead, flagsRead,
+        stackCfgWrite, stackCfgUpdate, stackKeepAlive, stackCfgRead, stackCellsMeasure, stackCellsRead,
+        stackTemperatureMeasure, stackTemperatureRead, stackFlagsRead, stackScanRead, scanPeriod,
+        operations
+       };
+
+      /**
+       * Durations of one operation in microseconds.
+       */
+      struct Timing
+       {
+        unsigned long calls;
+        unsigned long total;
+        unsigned long min;
+        unsigned long max;
+       };
+
+      /**
+       * Collected data, dumpable as is.
+       */
+      struct Report
+       {
+        Timing timings[operations];
+        unsigned long retries;
+        unsigned long polls;
+       };
+
+      /**
+       * Measures the lifetime of a scope as one call of an operation.
+       */
+      class Scope
+       {
+        public:
+          /**
+           * Constructor.
+           *
+           * @param operation Profiled operation
+           */
+          explicit Scope(const Operation operation) : operation(operation), start(micros())
+           {
+           }
+
+          /**
+           * Destructor.
+           */
+          ~Scope()
+           {
+            record(operation, micros() - start);
+           }
+
+          Scope(const Scope &) = delete;
+          Scope &operator=(const Scope &) = delete;
+
+        private:
+          /**
+           * Profiled operation.
+           */
+          const Operation operation;
+
+          /**
+           * Start time in microseconds.
+           */
+          const unsigned long start;
+       };
+
+      /**
+       * Record one call of an operation.
+       *
+       * @param operation Profiled operation
+       * @param duration Duration in microseconds
+       */
+      static void record(Operation operation, unsigned long duration);
+
+      /**
+       * Count a PEC retry.
+       */
+      static void retry() {++report.retries;}
+
+      /**
+       * Count a conversion poll that found the A/D converter busy.
+       */
+      static void poll() {++report.polls;}
+
+      /**
+       * Get collected data.
+       *
+       * @return Report
+       */
+      static const Report &get() {return (report);}
+
+      /**
+       * Get mean duration of an operation.
+       *
+       * @param operation Profiled operation
+       * @return Mean duration in microseconds, 0 when never called
+       */
+      static unsigned long getMean(Operation operation);
+
+      /**
+       * Clear collected data.
+       */
+      static void reset();
+
+      /**
+       * Output one line per called operation (name, calls, min, mean and max micros) and the counters to Serial.
+       */
+      static void debugOutput();
+
+    private:
+      /**
+       * Collected data.
+       */
+      static Report report;
+   };
+
+  #ifdef LTC6802_PROFILE
+    #define LTC6802_PROFILE_SCOPE(operation) const LTC6802Profile::Scope ltc6802ProfileScope(LTC6802Profile::operation)
+    #define LTC6802_PROFILE_RETRY() LTC6802Profile::retry()
+    #define LTC6802_PROFILE_POLL() LTC6802Profile::poll()
+    #define LTC6802_PROFILE_RECORD(operation, duration) LTC6802Profile::record(LTC6802Profile::operation, duration)
+  #else
+    #define LTC6802_PROFILE_SCOPE(operation) do {} while (false)
+    #define LTC6802_PROFILE_RETRY() do {} while (false)
+    #define LTC6802_PROFILE_POLL() do {} while (false)
+    #define LTC6802_PROFILE_RECORD(operation, duration) do {} while (false)
+  #endif
+
+#endif
@@ -0,0 +1,284 @@
+/**
+ * Copyright 2017, 2019 Dipl.-Inform. Kai Hofmann
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef LTC6802REGISTERS_H_INCLUDED_
+  #define LTC6802REGISTERS_H_INCLUDED_
+
+  #include <LTC6802Platform.h>
+
+  /**
+   * Write configuration register group.
+   */
+  static const byte WRCFG   = 0x01;
+
+  /**
+   * Read configuration register group.
+   */
+  static const byte RDCFG   = 0x02;
+
+  /**
+   * Read cellvoltage register group.
+   */
+  static const byte RDCV    = 0x04;
+
+  /**
+   * Read flag register group.
+   */
+  static const byte RDFLG   = 0x06;
+
+  /**
+   * Read temperature register group.
+   */
+  static const byte RDTMP   = 0x08;
+
+  /**
+   * Start cell voltage A/D conversion and poll status.
+   *
+   * | 0x00 : all cell voltage inputs
+   * | 0x01 : cell 1 only
+   * | 0x02 : cell 2 only
+   * | 0x03 : cell 3 only
+   * | 0x04 : cell 4 only
+   * | 0x05 : cell 5 only
+   * | 0x06 : cell 6 only
+   * | 0x07 : cell 7 only
+   * | 0x08 : cell 8 only
+   * | 0x09 : cell 9 only
+   * | 0x0a : cell 10 only
+   * | 0x0b : cell 11 only, if CELL10 bit=0
+   * | 0x0c : cell 12 only, if CELL10 bit=0
+   * | 0x0e : cell self test 1; all CV=0x555
+   * | 0x0f : cell self test 2; all CV=0xaaa
+   */
+  static const byte STCVAD  = 0x10;
+
+  /**
+   * Start Open-Wire A/D conversion and poll status.
+   *
+   * | 0x00 : all cell voltage inputs
+   * | 0x01 : cell 1 only
+   * | 0x02 : cell 2 only
+   * | 0x03 : cell 3 only
+   * | 0x04 : cell 4 only
+   * | 0x05 : cell 5 only
+   * | 0x06 : cell 6 only
+   * | 0x07 : cell 7 only
+   * | 0x08 : cell 8 only
+   * | 0x09 : cell 9 only
+   * | 0x0a : cell 10 only
+   * | 0x0b : cell 11 only, if CELL10 bit=0
+   * | 0x0c : cell 12 only, if CELL10 bit=0
+   * | 0x0e : cell self test 1; all CV=0x555
+   * | 0x0f : cell self test 2; all CV=0xaaa
+   */
+  static const byte STOWAD  = 0x20;
+
+  /**
+   * Start temperature A/D conversion and poll status.
+   *
+   * | 0x00 : all temperature inputs
+   * | 0x01 : external temp 1 only
+   * | 0x02 : external temp 2 only
+   * | 0x03 : internal temp only
+   * | 0x0e : temp self test 1; all TMP=0x555
+   * | 0x0f : temp self test 2; all TMP=0xaaa
+   */
+  static const byte STTMPAD = 0x30;
+
+  /**
+   * Poll A/D convertr status.
+   */
+  static const byte PLADC   = 0x40;
+
+  /**
+   * Poll interrupt status.
+   */
+  static const byte PLINT   = 0x50;
+
+  /**
+   * Start cell voltage A/D conversion and poll status, with discharge permitted.
+   *
+   * | 0x00 : all cell voltage inputs
+   * | 0x01 : cell 1 only
+   * | 0x02 : cell 2 only
+   * | 0x03 : cell 3 only
+   * | 0x04 : cell 4 only
+   * | 0x05 : cell 5 only
+   * | 0x06 : cell 6 only
+   * | 0x07 : cell 7 only
+   * | 0x08 : cell 8 only
+   * | 0x09 : cell 9 only
+   * | 0x0a : cell 10 only
+   * | 0x0b : cell 11 only, if CELL10 bit=0
+   * | 0x0c : cell 12 only, if CELL10 bit=0
+   * | 0x0e : cell self test 1; all CV=0x555
+   * | 0x0f : cell self test 2; all CV=0xaaa
+   */
+  static const byte STCDC   = 0x60;
+
+  /**
+   * Start open-Wire A/D conversions and poll status, with Discharge Permitted.
+   *
+   * | 0x00 : all cell voltage inputs
+   * | 0x01 : cell 1 only
+   * | 0x02 : cell 2 only
+   * | 0x03 : cell 3 only
+   * | 0x04 : cell 4 only
+   * | 0x05 : cell 5 only
+   * | 0x06 : cell 6 only
+   * | 0x07 : cell 7 only
+   * | 0x08 : cell 8 only
+   * | 0x09 : cell 9 only
+   * | 0x0a : cell 10 only
+   * | 0x0b : cell 11 only, if CELL10 bit=0
+   * | 0x0c : cell 12 only, if CELL10 bit=0
+   * | 0x0e : cell self test 1; all CV=0x555
+   * | 0x0f : cell self test 2; all CV=0xaaa
+   */
+  static const byte STOWDC  = 0x70;
+
+  /**
+   * Configuration register 0 watchdog timer bit.
+   */
+  static const byte CFG0_WDT_BIT    = 7;
+
+  /**
+   * Configuration register 0 GPIO2 bit.
+   */
+  static const byte CFG0_GPIO2_BIT  = 6;
+
+  /**
+   * Configuration register 0 GPIO1 bit.
+   */
+  static const byte CFG0_GPIO1_BIT  = 5;
+
+  /**
+   * Configuration register 0 level polling mode bit.
+   */
+  static const byte CFG0_LVLPL_BIT  = 4;
+
+  /**
+   * Configuration register 0 10-cell mode bit.
+   */
+  static const byte CFG0_CELL10_BIT = 3;
+
+  // static const byte CFG0_CDC_BITS   = 0-2;
+  // static const byte CFG1_DCC_BITS   = 0-7;
+  // static const byte CFG2_DCC_BITS   = 0-3;
+  // static const byte CFG2_MCI_BITS   = 4-7;
+  // static const byte CFG3_MCI_BITS   = 0-7;
+
+  /**
+   * Configuration register 0 watchdog timer bitmask.
+   */
+  static const byte CFG0_WDT_MSK    = 0x80;
+
+  /**
+   * Configuration register 0 GPIO2 bitmask.
+   */
+  static const byte CFG0_GPIO2_MSK  = 0x40;
+
+  /**
+   * Configuration register 0 GPIO1 bitmask.
+   */
+  static const byte CFG0_GPIO1_MSK  = 0x20;
+
+  /**
+   * Configuration register 0 level polling bitmask.
+   */
+  static const byte CFG0_LVLPL_MSK  = 0x10;
+
+  /**
+   * Configuration register 0 10-cell mode bitmask.
+   */
+  static const byte CFG0_CELL10_MSK = 0x08;
+
+  /**
+   * Configuration register 0 comparator duty cycle bitmask.
+   */
+  static const byte CFG0_CDC_MSK    = 0x07;
+
+  /**
+   * Configuration register 1 discharge cell bitmask.
+   */
+  static const byte CFG1_DCC_MSK    = 0xff;
+
+  /**
+   * Configuration register 2 discharge cell bitmask.
+   */
+  static const byte CFG2_DCC_MSK    = 0x0f;
+
+  /**
+   * Configuration register 2 mask cell interrupts bitmask.
+   */
+  static const byte CFG2_MCI_MSK    = 0xf0;
+
+  /**
+   * Configuration register 3 mask cell interrupts bitmask.
+   */
+  static const byte CFG3_MCI_MSK    = 0xff;
+
+
+  /**
+   * Configuration register 0 watchdog timer inverse bitmask.
+   */
+  static const byte CFG0_WDT_INVMSK    = 0x7f;
+
+  /**
+   * Configuration register 0 GPIO2 inverse bitmask.
+   */
+  static const byte CFG0_GPIO2_INVMSK  = 0xbf;
+
+  /**
+   * Configuration register 0 GPIO1 inverse bitmask.
+   */
+  static const byte CFG0_GPIO1_INVMSK  = 0xdf;
+
+  /**
+   * Configuration register 0 level polling mode inverse bitmask.
+   */
+  static const byte CFG0_LVLPL_INVMSK  = 0xef;
+
+  /**
+   * Configuration register 0 10-cell mode inverse bitmask.
+   */
+  static const byte CFG0_CELL10_INVMSK = 0xf7;
+
+  /**
+   * Configuration register 0 comparator duty cycle inverse bitmask.
+   */
+  static const byte CFG0_CDC_INVMSK    = 0xf8;
+
+  /**
+   * Configuration register 1 discharge cell inverse bitmask.
+   */
+  static const byte CFG1_DCC_INVMSK    = 0x00;
+
+  /**
+   * Configuration register 2 discharge cell inverse bitmask.
+   */
+  static const byte CFG2_DCC_INVMSK    = 0xf0;
+
+  /**
+   * Configuration register 2 mask cell interrupts inverse bitmask.
+   */
+  static const byte CFG2_MCI_INVMSK    = 0x0f;
+
+  /**
+   * Configuration register 3 mask cell interrupts inverse bitmask.
+   */
+  static const byte CFG3_MCI_INVMSK    = 0x00;
+
+#endif
@@ -0,0 +1,117 @@
+/**
+ * Copyright 2017, 2019 Dipl.-Inform. Kai Hofmann
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifdef ARDUINO
+
+#include <LTC6802SPITransport.h>
+
+
+LTC6802SPITransport &LTC6802SPITransport::standard()
+ {
+  // Function local, so chips constructed as globals in other units never see it uninitialized
+  static LTC6802SPITransport standardTransport(SPI);
+  return standardTransport;
+ }
+
+
+LTC6802SPITransport::LTC6802SPITransport(SPIClass &spi, const unsigned long clock)
+ : spi(spi), clock(clock), settings(SPISettings(clock, MSBFIRST, SPI_MODE3))
+ {
+ }
+
+
+void LTC6802SPITransport::begin(const byte pinMOSI, const byte pinMISO, const byte pinCLK)
+ {
+  // TODO parameters for different arduinos (pins)
+  pinMode(pinMOSI, OUTPUT);
+  pinMode(pinMISO, INPUT);
+  pinMode(pinCLK, OUTPUT);
+
+  // SPI.setBitOrder(MSBFIRST);
+  // SPI.setDataMode(SPI_MODE3);
+  // SPI.setClockDivider(SPI_CLOCK_DIV16);
+  // SPI.begin();
+
+  // SPI.begin(ETHERNET_SHIELD_SPI_CS);
+  // SPI.setClockDivider(ETHERNET_SHIELD_SPI_CS, SPI_CLOCK_DIV16);
+  // SPI.setDataMode(ETHERNET_SHIELD_SPI_CS, SPI_MODE3);
+ }
+
+
+void LTC6802SPITransport::end()
+ {
+  // SPI.end();
+ }
+
+
+void LTC6802SPITransport::setClock(const unsigned long hz)
+ {
+  clock = hz;
+  settings = SPISettings(hz, MSBFIRST, SPI_MODE3);
+ }
+
+
+unsigned long LTC6802SPITransport::getClock() const
+ {
+  return clock;
+ }
+
+
+void LTC6802SPITransport::attach(const byte csPin)
+ {
+  pinMode(csPin, OUTPUT);
+  digitalWrite(csPin, HIGH);
+ }
+
+
+void LTC6802SPITransport::select(const byte csPin)
+ {
+  spi.beginTransaction(settings);
+  digitalWrite(csPin, LOW);
+ }
+
+
+void LTC6802SPITransport::deselect(const byte csPin)
+ {
+  digitalWrite(csPin, HIGH);
+  spi.endTransaction();
+ }
+
+
+void LTC6802SPITransport::suspend(byte)
+ {
+  // Lets interrupts registered with SPI.usingInterrupt() through while chip select stays low
+  spi.endTransaction();
+ }
+
+
+void LTC6802SPITransport::resume(byte)
+ {
+  spi.beginTransaction(settings);
+ }
+
+
+byte LTC6802SPITransport::transfer(const byte data)
+ {
+  return spi.transfer(data);
+ }
+
+
+void LTC6802SPITransport::transfer(byte *const buf, const size_t len)
+ {
+  spi.transfer(buf, len);
+ }
+
+#endif
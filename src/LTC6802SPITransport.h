@@ -0,0 +1,89 @@
+/**
+ * Copyright 2017, 2019 Dipl.-Inform. Kai Hofmann
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef LTC6802SPITRANSPORT_H_INCLUDED_
+  #define LTC6802SPITRANSPORT_H_INCLUDED_
+
+  #ifdef ARDUINO
+
+    #include <LTC6802Transport.h>
+    #include <SPI.h>
+
+    /**
+     * LTC6802 transport on an Arduino hardware SPI bus.
+     */
+    class LTC6802SPITransport : public LTC6802Transport
+     {
+      public:
+        /**
+         * Get transport on the default SPI bus.
+         *
+         * @return Transport used by chips constructed without an explicit transport
+         */
+        static LTC6802SPITransport &standard();
+
+        /**
+         * Constructor.
+         *
+         * @param spi SPI bus
+         * @param clock SPI clock rate in Hz
+         */
+        explicit LTC6802SPITransport(SPIClass &spi, unsigned long clock = 1000000);
+
+        /**
+         * Init SPI bus pins.
+         *
+         * @param pinMOSI Pin for master out slave in
+         * @param pinMISO Pin for master in slave out
+         * @param pinCLK Pin for clock
+         */
+        void begin(byte pinMOSI, byte pinMISO, byte pinCLK);
+
+        /**
+         * Destroy SPI bus.
+         */
+        void end();
+
+        void setClock(unsigned long hz) override;
+        unsigned long getClock() const override;
+        void attach(byte csPin) override;
+        void select(byte csPin) override;
+        void deselect(byte csPin) override;
+        void suspend(byte csPin) override;
+        void resume(byte csPin) override;
+        byte transfer(byte data) override;
+        void transfer(byte *buf, size_t len) override;
+
+      private:
+        /**
+         * SPI bus.
+         */
+        SPIClass &spi;
+
+        /**
+         * SPI clock rate in Hz.
+         */
+        unsigned long clock;
+
+        /**
+         * SPI settings.
+         */
+        SPISettings settings;
+
+     };
+
+  #endif
+
+#endif
@@ -0,0 +1,139 @@
+/**
+ * Copyright 2017, 2019 Dipl.-Inform. Kai Hofmann
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <LTC6802ScanPipeline.h>
+#include <LTC6802Profile.h>
+
+
+const LTC6802ScanPipeline::Phase LTC6802ScanPipeline::defaultPlan[2] =
+ {
+  {cells, temperaturesGroup | cfgGroup},
+  {temperatures, cellsGroup | flagsGroup}
+ };
+
+
+LTC6802ScanPipeline::LTC6802ScanPipeline(LTC6802StackBase &stack, const Phase *const plan, const byte phases)
+ : stack(stack), plan(plan), phases(phases)
+ {
+ }
+
+
+void LTC6802ScanPipeline::begin()
+ {
+  phase = 0;
+  cycles = 0;
+  period = 0;
+  cycleStart = micros();
+  start();
+ }
+
+
+LTC6802::Status LTC6802ScanPipeline::step()
+ {
+  const Phase &current = plan[phase];
+  byte groups = current.groups;
+  // Registers the running conversion writes read as 0xff
+  if (current.conversion == cells)
+   {
+    groups &= ~(cellsGroup | flagsGroup);
+   }
+  else if (current.conversion == temperatures)
+   {
+    groups &= ~temperaturesGroup;
+   }
+  LTC6802::Status status = LTC6802::ok;
+  if (groups & temperaturesGroup)
+   {
+    keep(status, stack.temperatureRead());
+   }
+  if (groups & cellsGroup)
+   {
+    keep(status, stack.cellsRead());
+   }
+  if (groups & flagsGroup)
+   {
+    keep(status, stack.flagsRead());
+   }
+  if (groups & cfgGroup)
+   {
+    keep(status, stack.cfgVerify());
+   }
+  LTC6802::Status conversion;
+  while ((conversion = stack.poll()) == LTC6802::busy)
+   {
+    delayMicroseconds(pollInterval);
+   }
+  keep(status, conversion);
+  if (++phase == phases)
+   {
+    const unsigned long now = micros();
+    phase = 0;
+    ++cycles;
+    period = now - cycleStart;
+    cycleStart = now;
+    LTC6802_PROFILE_RECORD(scanPeriod, period);
+   }
+  start();
+  return status;
+ }
+
+
+LTC6802::Status LTC6802ScanPipeline::scan()
+ {
+  LTC6802::Status status = LTC6802::ok;
+  do
+   {
+    keep(status, step());
+   }
+  while (phase != 0);
+  return status;
+ }
+
+
+unsigned long LTC6802ScanPipeline::getCycles() const
+ {
+  return cycles;
+ }
+
+
+unsigned long LTC6802ScanPipeline::getPeriod() const
+ {
+  return period;
+ }
+
+
+void LTC6802ScanPipeline::start()
+ {
+  switch (plan[phase].conversion)
+   {
+    case cells:
+      stack.cellsMeasure();
+      break;
+    case temperatures:
+      stack.temperatureMeasure();
+      break;
+    default:
+      break;
+   }
+ }
+
+
+void LTC6802ScanPipeline::keep(LTC6802::Status &status, const LTC6802::Status result)
+ {
+  if (status == LTC6802::ok)
+   {
+    status = result;
+   }
+ }
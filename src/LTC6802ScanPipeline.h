@@ -0,0 +1,183 @@
+/**
+ * Copyright 2017, 2019 Dipl.-Inform. Kai Hofmann
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef LTC6802SCANPIPELINE_H_INCLUDED_
+  #define LTC6802SCANPIPELINE_H_INCLUDED_
+
+  #include <LTC6802Stack.h>
+
+  /**
+   * Scan of cells, temperatures, flags and configuration with overlapped phases.
+   *
+   * The A/D converter runs one conversion at a time, but register groups
+   * that are not being converted can be read meanwhile. A plan is a cycle
+   * of phases, each starting one conversion and reading the results of the
+   * earlier ones while it runs, so a cycle takes little more than the sum
+   * of its conversion times. The default plan reads temperatures and
+   * configuration during the cell conversion and cells and flags during
+   * the temperature conversion. Results are complete after the first cycle.
+   * Call keepAlive() or cfgUpdate() in between to restore configurations the
+   * read back found changed.
+   */
+  class LTC6802ScanPipeline
+   {
+    public:
+      /**
+       * Conversion of a phase.
+       */
+      enum Conversion : byte {none, cells, temperatures};
+
+      /**
+       * Register group read in a phase.
+       */
+      static const byte cellsGroup = 0x01;
+
+      /**
+       * Register group read in a phase.
+       */
+      static const byte temperaturesGroup = 0x02;
+
+      /**
+       * Register group read in a phase.
+       */
+      static const byte flagsGroup = 0x04;
+
+      /**
+       * Register group read in a phase, into the shadow checked by cfgUpdate() (see LTC6802StackBase::cfgVerify()).
+       */
+      static const byte cfgGroup = 0x08;
+
+      /**
+       * One phase of a plan.
+       */
+      struct Phase
+       {
+        /**
+         * Conversion started at the beginning of the phase.
+         */
+        Conversion conversion;
+
+        /**
+         * Register groups read while it runs; groups it converts into are skipped.
+         */
+        byte groups;
+       };
+
+      /**
+       * Default plan: cells, then temperatures.
+       */
+      static const Phase defaultPlan[2];
+
+      /**
+       * Constructor.
+       *
+       * @param stack Chips to scan
+       * @param plan Phases of one cycle, kept by reference
+       * @param phases Number of phases
+       */
+      LTC6802ScanPipeline(LTC6802StackBase &stack, const Phase *plan = defaultPlan, byte phases = 2);
+
+      /**
+       * Start the conversion of the first phase.
+       */
+      void begin();
+
+      /**
+       * Run the reads of the current phase, wait for its conversion and start the next phase.
+       *
+       * @return ok; first timeout or pecError of the phase
+       */
+      LTC6802::Status step();
+
+      /**
+       * Run the remaining phases of the current cycle.
+       *
+       * @return ok; first timeout or pecError of the cycle
+       */
+      LTC6802::Status scan();
+
+      /**
+       * Get completed cycles.
+       *
+       * @return Cycles since begin()
+       */
+      unsigned long getCycles() const;
+
+      /**
+       * Get duration of the last complete cycle.
+       *
+       * Also recorded as LTC6802Profile::scanPeriod with LTC6802_PROFILE.
+       *
+       * @return Microseconds, 0 : no cycle completed yet
+       */
+      unsigned long getPeriod() const;
+
+    private:
+      /**
+       * Pause between two PLADC polls while waiting, in microseconds.
+       */
+      static const unsigned int pollInterval = 250;
+
+      /**
+       * Chips to scan.
+       */
+      LTC6802StackBase &stack;
+
+      /**
+       * Phases of one cycle.
+       */
+      const Phase *plan;
+
+      /**
+       * Number of phases.
+       */
+      byte phases;
+
+      /**
+       * Current phase.
+       */
+      byte phase = 0;
+
+      /**
+       * Completed cycles.
+       */
+      unsigned long cycles = 0;
+
+      /**
+       * Start of the current cycle in microseconds.
+       */
+      unsigned long cycleStart = 0;
+
+      /**
+       * Duration of the last cycle in microseconds.
+       */
+      unsigned long period = 0;
+
+      /**
+       * Start the conversion of the current phase.
+       */
+      void start();
+
+      /**
+       * Keep the first error.
+       *
+       * @param status Status so far
+       * @param result Status of the next operation
+       */
+      static void keep(LTC6802::Status &status, LTC6802::Status result);
+
+   };
+
+#endif
@@ -0,0 +1,111 @@
+/**
+ * Copyright 2017, 2019 Dipl.-Inform. Kai Hofmann
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <LTC6802SelfTest.h>
+
+
+LTC6802SelfTest::LTC6802SelfTest(LTC6802StackBase &stack, byte *const results, byte *const frame, const byte budget)
+ : stack(stack), results(results), frame(frame)
+ {
+  for (byte chip = 0; chip < stack.getNumChips(); ++chip)
+   {
+    results[chip] = 0;
+   }
+  setBudget(budget);
+ }
+
+
+void LTC6802SelfTest::setBudget(const byte budget)
+ {
+  const byte numChips = stack.getNumChips();
+  this->budget = (budget < 1) ? 1 : ((budget > numChips) ? numChips : budget);
+ }
+
+
+LTC6802::Status LTC6802SelfTest::step()
+ {
+  LTC6802::Status status;
+  if (!read)
+   {
+    if (!running)
+     {
+      stack.selfTestMeasure(test);
+      running = true;
+      return LTC6802::busy;
+     }
+    status = stack.selfTestRead(test, frame);
+    if (status == LTC6802::busy)
+     {
+      return status;
+     }
+    running = false;
+    if (status != LTC6802::ok)
+     {
+      return status;
+     }
+    read = true;
+    chip = 0;
+   }
+  // All chips converted the pattern, compare the budget of them from the frame
+  status = LTC6802::ok;
+  const byte numChips = stack.getNumChips();
+  for (byte checked = 0; (checked < budget) && (chip < numChips); ++checked, ++chip)
+   {
+    if (!stack.selfTestCheck(test, chip, frame))
+     {
+      results[chip] |= 0x10 << test;
+      status = LTC6802::selfTestError;
+     }
+   }
+  if (chip < numChips)
+   {
+    return status;
+   }
+  read = false;
+  if (++test == tests)
+   {
+    test = 0;
+    ++rounds;
+    for (byte i = 0; i < numChips; ++i)
+     {
+      results[i] >>= 4;
+     }
+   }
+  return status;
+ }
+
+
+bool LTC6802SelfTest::isRunning() const
+ {
+  return running;
+ }
+
+
+bool LTC6802SelfTest::passed(const byte chip) const
+ {
+  return (rounds != 0) && ((results[chip] & 0x0f) == 0);
+ }
+
+
+byte LTC6802SelfTest::getFailures(const byte chip) const
+ {
+  return (rounds == 0) ? untested : (results[chip] & 0x0f);
+ }
+
+
+unsigned long LTC6802SelfTest::getRounds() const
+ {
+  return rounds;
+ }
@@ -0,0 +1,150 @@
+/**
+ * Copyright 2017, 2019 Dipl.-Inform. Kai Hofmann
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef LTC6802SELFTEST_H_INCLUDED_
+  #define LTC6802SELFTEST_H_INCLUDED_
+
+  #include <LTC6802Stack.h>
+
+  /**
+   * Continuous A/D self test of a stack as a background task.
+   *
+   * Every self test conversion runs on all chips at once and is read once
+   * into a separate frame, so four conversions (both patterns for cells and
+   * temperatures) complete a round over the whole stack. step() never waits
+   * for a conversion: it starts a test, reads it in a later step once the
+   * conversion finished, and then compares a budget of chips per step, by
+   * default one chip per scan slot. No other conversion may be started on
+   * the stack while a test converts (isRunning()); the compare steps leave
+   * the stack free.
+   */
+  class LTC6802SelfTest
+   {
+    public:
+      /**
+       * Number of self tests per round: cells 0x555, cells 0xaaa, temperatures 0x555, temperatures 0xaaa.
+       */
+      static const byte tests = 4;
+
+      /**
+       * Result of a chip before the first round completed.
+       */
+      static const byte untested = 0x80;
+
+      /**
+       * Constructor.
+       *
+       * @param stack Chips to test
+       * @param results Array for numChips results
+       * @param frame Frame buffer of LTC6802StackBase::selfTestFrameSize(numChips) bytes
+       * @param budget Chips compared per step
+       */
+      LTC6802SelfTest(LTC6802StackBase &stack, byte *results, byte *frame, byte budget = 1);
+
+      /**
+       * Set number of chips compared per step.
+       *
+       * @param budget Chips, clamped to 1 - numChips
+       */
+      void setBudget(byte budget);
+
+      /**
+       * Start the next test, read the running one or compare the next chips of the read one.
+       *
+       * A test with a timeout or PEC error is repeated in the next step.
+       *
+       * @return busy while the test converts; ok when the compared chips passed; selfTestError if one of them failed; timeout; pecError
+       */
+      LTC6802::Status step();
+
+      /**
+       * Check for running test conversion.
+       *
+       * @return true while step() has to be called before other conversions
+       */
+      bool isRunning() const;
+
+      /**
+       * Check whether all tests of a chip passed in the last completed round.
+       *
+       * @param chip Chip index, 0 : bottom chip
+       * @return true if passed
+       */
+      bool passed(byte chip) const;
+
+      /**
+       * Get failed tests of a chip in the last completed round.
+       *
+       * @param chip Chip index, 0 : bottom chip
+       * @return Bit n : test n failed; untested
+       */
+      byte getFailures(byte chip) const;
+
+      /**
+       * Get number of completed rounds.
+       *
+       * @return Rounds
+       */
+      unsigned long getRounds() const;
+
+    private:
+      /**
+       * Chips to test.
+       */
+      LTC6802StackBase &stack;
+
+      /**
+       * Per chip: failed tests of the last round in the low nibble, of the running round in the high nibble.
+       */
+      byte *results;
+
+      /**
+       * Frame buffer for the test results of all chips.
+       */
+      byte *frame;
+
+      /**
+       * Chips compared per step.
+       */
+      byte budget;
+
+      /**
+       * Next or running test.
+       */
+      byte test = 0;
+
+      /**
+       * Test conversion started.
+       */
+      bool running = false;
+
+      /**
+       * Test read into the frame, chips from chip on still to compare.
+       */
+      bool read = false;
+
+      /**
+       * Next chip to compare.
+       */
+      byte chip = 0;
+
+      /**
+       * Completed rounds.
+       */
+      unsigned long rounds = 0;
+
+   };
+
+#endif
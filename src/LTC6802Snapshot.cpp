@@ -0,0 +1,100 @@
+/**
+ * Copyright 2017, 2019 Dipl.-Inform. Kai Hofmann
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <LTC6802Snapshot.h>
+#include <string.h>
+#ifdef __AVR__
+  #include <util/atomic.h>
+#endif
+
+
+void LTC6802Snapshot::View::cellsGetMillivolts(uint16_t *const millivolts) const
+ {
+  for (byte chip = 0; chip < numChips; ++chip)
+   {
+    LTC6802::cellsDecode(cells(chip), &millivolts[chip * LTC6802::maxCells], true);
+   }
+ }
+
+
+LTC6802Snapshot::LTC6802Snapshot(const byte numChips, byte *const buffer)
+ {
+  memset(buffer, 0, bufferSize(numChips));
+  for (byte i = 0; i < 3; ++i)
+   {
+    views[i].data = &buffer[i * numChips * chipBytes];
+    views[i].numChips = numChips;
+   }
+ }
+
+
+void LTC6802Snapshot::publish(const LTC6802StackBase &stack)
+ {
+  View &view = views[back];
+  for (byte chip = 0; chip < view.numChips; ++chip)
+   {
+    // Same order as the View accessors
+    byte *dst = &view.data[chip * chipBytes];
+    memcpy(dst, stack.cfg(chip), LTC6802::cfgRegisters);
+    dst += LTC6802::cfgRegisters;
+    memcpy(dst, stack.cells(chip), LTC6802::cellRegisters);
+    dst += LTC6802::cellRegisters;
+    memcpy(dst, stack.temperatures(chip), LTC6802::tmpRegisters);
+    dst += LTC6802::tmpRegisters;
+    memcpy(dst, stack.flags(chip), LTC6802::flgRegisters);
+   }
+  view.sequence = ++published;
+  view.timestamp = micros();
+  back = exchange(back | freshFlag) & indexMask;
+ }
+
+
+unsigned long LTC6802Snapshot::getPublished() const
+ {
+  return published;
+ }
+
+
+bool LTC6802Snapshot::update()
+ {
+  if ((middle & freshFlag) == 0)
+   {
+    return false;
+   }
+  front = exchange(front) & indexMask;
+  return true;
+ }
+
+
+const LTC6802Snapshot::View &LTC6802Snapshot::get() const
+ {
+  return views[front];
+ }
+
+
+byte LTC6802Snapshot::exchange(const byte value)
+ {
+#ifdef __AVR__
+  byte previous;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+   {
+    previous = middle;
+    middle = value;
+   }
+  return previous;
+#else
+  return __atomic_exchange_n(&middle, value, __ATOMIC_ACQ_REL);
+#endif
+ }
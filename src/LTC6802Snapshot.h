@@ -0,0 +1,215 @@
+/**
+ * Copyright 2017, 2019 Dipl.-Inform. Kai Hofmann
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef LTC6802SNAPSHOT_H_INCLUDED_
+  #define LTC6802SNAPSHOT_H_INCLUDED_
+
+  #include <LTC6802Stack.h>
+
+  /**
+   * Coherent snapshots of complete stack scans for a consumer in another context.
+   *
+   * Triple buffer: the acquisition copies the registers of a finished scan
+   * into the back buffer and publishes it by swapping it with the middle
+   * buffer, the consumer takes the middle buffer by swapping it with its
+   * front buffer. Both swaps are a single atomic exchange, so neither side
+   * ever waits, the consumer never sees a half updated scan and reads it in
+   * place without copying. One publishing and one consuming context
+   * (interrupt, RTOS task or thread) per snapshot.
+   */
+  class LTC6802Snapshot
+   {
+    public:
+      /**
+       * Bytes per chip in a buffer (configuration, cell, temperature and flag registers).
+       */
+      static const byte chipBytes = LTC6802::cfgRegisters + LTC6802::cellRegisters + LTC6802::tmpRegisters + LTC6802::flgRegisters;
+
+      /**
+       * Get size of the snapshot buffer.
+       *
+       * @param numChips Number of chips
+       * @return Bytes for three buffers
+       */
+      static constexpr unsigned int bufferSize(const byte numChips) {return 3U * numChips * chipBytes;}
+
+      /**
+       * Read only view of one published scan.
+       */
+      class View
+       {
+        public:
+          /**
+           * Get number of the scan.
+           *
+           * @return Scans published up to this one, 0 : none yet
+           */
+          unsigned long getSequence() const {return (sequence);}
+
+          /**
+           * Get time the scan was published.
+           *
+           * @return micros() at publish
+           */
+          unsigned long getTimestamp() const {return (timestamp);}
+
+          /**
+           * Get configuration registers of a chip.
+           *
+           * @param chip Chip index, 0 : bottom chip
+           * @return 6 configuration registers
+           */
+          const byte *cfg(const byte chip) const {return (&data[chip * chipBytes]);}
+
+          /**
+           * Get cell registers of a chip.
+           *
+           * @param chip Chip index, 0 : bottom chip
+           * @return 18 cell registers
+           */
+          const byte *cells(const byte chip) const {return (&data[chip * chipBytes + LTC6802::cfgRegisters]);}
+
+          /**
+           * Get temperature registers of a chip.
+           *
+           * @param chip Chip index, 0 : bottom chip
+           * @return 5 temperature registers
+           */
+          const byte *temperatures(const byte chip) const {return (&data[chip * chipBytes + LTC6802::cfgRegisters + LTC6802::cellRegisters]);}
+
+          /**
+           * Get flag registers of a chip.
+           *
+           * @param chip Chip index, 0 : bottom chip
+           * @return 3 flag registers
+           */
+          const byte *flags(const byte chip) const {return (&data[chip * chipBytes + LTC6802::cfgRegisters + LTC6802::cellRegisters + LTC6802::tmpRegisters]);}
+
+          /**
+           * Get cell voltages of all chips.
+           *
+           * @param millivolts Array for numChips * 12 voltages in mV, chip 0 first
+           */
+          void cellsGetMillivolts(uint16_t *millivolts) const;
+
+        private:
+          friend class LTC6802Snapshot;
+
+          /**
+           * Registers, chipBytes per chip.
+           */
+          byte *data = 0;
+
+          /**
+           * Number of chips.
+           */
+          byte numChips = 0;
+
+          /**
+           * Number of the scan.
+           */
+          unsigned long sequence = 0;
+
+          /**
+           * Publish time in microseconds.
+           */
+          unsigned long timestamp = 0;
+       };
+
+      /**
+       * Constructor.
+       *
+       * @param numChips Number of chips
+       * @param buffer Snapshot buffer of bufferSize(numChips) bytes
+       */
+      LTC6802Snapshot(byte numChips, byte *buffer);
+
+      /**
+       * Publish the registers of a finished scan; publishing side.
+       *
+       * @param stack Stack holding the scan
+       */
+      void publish(const LTC6802StackBase &stack);
+
+      /**
+       * Get number of published scans; publishing side.
+       *
+       * @return Scans published
+       */
+      unsigned long getPublished() const;
+
+      /**
+       * Take the latest published scan if there is a new one; consuming side.
+       *
+       * @return true if get() now shows a newer scan
+       */
+      bool update();
+
+      /**
+       * Get the scan taken by the last update(); consuming side.
+       *
+       * Stays valid and unchanged until the next update().
+       *
+       * @return View, sequence 0 before the first scan
+       */
+      const View &get() const;
+
+    private:
+      /**
+       * Buffer index bits of the exchanged state.
+       */
+      static const byte indexMask = 0x03;
+
+      /**
+       * Middle buffer holds a scan the consumer has not taken yet.
+       */
+      static const byte freshFlag = 0x80;
+
+      /**
+       * Three buffers.
+       */
+      View views[3];
+
+      /**
+       * Buffer written by the publishing side.
+       */
+      byte back = 0;
+
+      /**
+       * Middle buffer index and fresh flag, exchanged by both sides.
+       */
+      volatile byte middle = 1;
+
+      /**
+       * Buffer read by the consuming side.
+       */
+      byte front = 2;
+
+      /**
+       * Scans published.
+       */
+      unsigned long published = 0;
+
+      /**
+       * Atomically replace the middle state.
+       *
+       * @param value New state
+       * @return Previous state
+       */
+      byte exchange(byte value);
+
+   };
+
+#endif
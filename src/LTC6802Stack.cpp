@@ -0,0 +1,765 @@
+/**
+ * Copyright 2017, 2019 Dipl.-Inform. Kai Hofmann
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <LTC6802Stack.h>
+#include <LTC6802Registers.h>
+#include <LTC6802PEC.h>
+#include <LTC6802Stats.h>
+#include <LTC6802Profile.h>
+
+
+LTC6802StackBase::LTC6802StackBase(LTC6802Transport &bus, const byte csPin, const byte numChips, byte *const buffer)
+ : LTC6802StackBase(bus, csPin, 0, numChips, buffer)
+ {
+ }
+
+
+LTC6802StackBase::LTC6802StackBase(LTC6802Transport &bus, const byte csPin, const byte firstAddress, const byte numChips, byte *const buffer)
+ : LTC6802StackBase(bus, csPin, firstAddress, numChips, LTC6802::maxCells,
+                    buffer,
+                    buffer + 1 + numChips * cfgFrameBytes,
+                    buffer + 2 + numChips * (cfgFrameBytes + cellFrameBytes),
+                    buffer + 3 + numChips * (cfgFrameBytes + cellFrameBytes + tmpFrameBytes),
+                    buffer + 4 + numChips * (cfgFrameBytes + cellFrameBytes + tmpFrameBytes + flgFrameBytes),
+                    buffer + 5 + numChips * (2 * cfgFrameBytes + cellFrameBytes + tmpFrameBytes + flgFrameBytes))
+ {
+ }
+
+
+LTC6802StackBase::LTC6802StackBase(LTC6802Transport &bus, const byte csPin, const byte firstAddress, const byte numChips, const byte cellsPerChip,
+                                   byte *const cfg, byte *const cv, byte *const tmp, byte *const flg, byte *const shd, byte *const err)
+ : bus(bus), csPin(csPin), firstAddress(firstAddress), numChips(numChips), cellsPerChip(cellsPerChip),
+   CFG(cfg + 1), CV(cv + 1), TMP(tmp + 1), FLG(flg + 1), SHD(shd + 1), ERR(err)
+ {
+  bus.attach(csPin);
+  for (unsigned int i = 0; i <= numChips * cfgFrameBytes; ++i)
+   {
+    cfg[i] = 0;
+    // Chip contents are unknown until the first write
+    shd[i] = 0xff;
+   }
+  for (unsigned int i = 0; i <= numChips * cellFrameBytes; ++i)
+   {
+    cv[i] = 0;
+   }
+  for (unsigned int i = 0; i <= numChips * tmpFrameBytes; ++i)
+   {
+    tmp[i] = 0;
+   }
+  for (unsigned int i = 0; i <= numChips * flgFrameBytes; ++i)
+   {
+    flg[i] = 0;
+   }
+  for (byte chip = 0; chip < numChips; ++chip)
+   {
+    err[chip] = 0;
+    if (cellsPerChip < LTC6802::maxCells)
+     {
+      CFG[chip * cfgFrameBytes] = CFG0_CELL10_MSK;
+     }
+   }
+ }
+
+
+byte LTC6802StackBase::getNumChips() const
+ {
+  return numChips;
+ }
+
+
+byte LTC6802StackBase::getCellsPerChip() const
+ {
+  return cellsPerChip;
+ }
+
+
+void LTC6802StackBase::measure(const byte cmd)
+ {
+  byte frame = cmd;
+  select();
+  bus.transfer(&frame, 1);
+  bus.deselect(csPin);
+  converting = true;
+  conversion = cmd;
+  conversionStart = micros();
+ }
+
+
+LTC6802::Status LTC6802StackBase::read(const byte cmd, const byte frameBytes, byte *const frame)
+ {
+  const Group group = {cmd, frameBytes, frame};
+  return readGroups(&group, 1);
+ }
+
+
+LTC6802::Status LTC6802StackBase::readGroups(const Group *const groups, const byte count)
+ {
+  for (int attempt = 0; attempt <= retries; ++attempt)
+   {
+    if (attempt > 0)
+     {
+      LTC6802_PROFILE_RETRY();
+     }
+    // The first attempt reads all frames, retries only the ones that failed the PEC check
+    const bool deferred = bus.batchBegin();
+    for (byte group = 0; group < count; ++group)
+     {
+      queueGroup(groups[group], attempt == 0, deferred);
+     }
+    bus.flush();
+    bool valid = true;
+    for (byte group = 0; group < count; ++group)
+     {
+      for (byte chip = 0; chip < numChips; ++chip)
+       {
+        valid = checkPec(chip, groups[group].frameBytes, &groups[group].frame[chip * groups[group].frameBytes]) && valid;
+       }
+     }
+    if (valid)
+     {
+      return LTC6802::ok;
+     }
+   }
+  return LTC6802::pecError;
+ }
+
+
+void LTC6802StackBase::queueGroup(const Group &group, const bool all, const bool deferred)
+ {
+  const byte frameBytes = group.frameBytes;
+  if (firstAddress == 0)
+   {
+    bool valid = !all;
+    for (byte chip = 0; valid && (chip < numChips); ++chip)
+     {
+      valid = LTC6802PEC::check(&group.frame[chip * frameBytes], frameBytes - 1);
+     }
+    if (valid)
+     {
+      return;
+     }
+    // The byte in front of each frame holds the command, so the whole chain is one transfer
+    const unsigned int len = (unsigned int)numChips * frameBytes + 1;
+    byte *const buf = group.frame - 1;
+    for (unsigned int i = 0; i < len; ++i)
+     {
+      buf[i] = group.cmd;
+     }
+    select();
+    bus.transfer(buf, len);
+    bus.deselect(csPin);
+    return;
+   }
+  for (byte chip = 0; chip < numChips; ++chip)
+   {
+    byte *const arr = &group.frame[chip * frameBytes];
+    if (!all && LTC6802PEC::check(arr, frameBytes - 1))
+     {
+      continue;
+     }
+    if (!deferred)
+     {
+      readChip(chip, group.cmd, frameBytes, arr);
+      continue;
+     }
+    // Received straight into the register buffer, which stays valid until flush()
+    const byte header[2] = {(byte)(firstAddress + chip), group.cmd};
+    for (int i = 0; i < frameBytes; ++i)
+     {
+      arr[i] = group.cmd;
+     }
+    select();
+    bus.send(header, 2);
+    bus.transfer(arr, frameBytes);
+    bus.deselect(csPin);
+   }
+ }
+
+
+bool LTC6802StackBase::checkPec(const byte chip, const byte frameBytes, const byte *const arr)
+ {
+  if (LTC6802PEC::check(arr, frameBytes - 1))
+   {
+    return true;
+   }
+  if (ERR[chip] < 0xff)
+   {
+    ++ERR[chip];
+   }
+  return false;
+ }
+
+
+void LTC6802StackBase::readChip(const byte chip, const byte cmd, const byte frameBytes, byte *const arr)
+ {
+  byte buf[2 + cellFrameBytes];
+  buf[0] = firstAddress + chip;
+  for (int i = 1; i < 2 + frameBytes; ++i)
+   {
+    buf[i] = cmd;
+   }
+  select();
+  bus.transfer(buf, 2 + frameBytes);
+  bus.deselect(csPin);
+  for (int i = 0; i < frameBytes; ++i)
+   {
+    arr[i] = buf[2 + i];
+   }
+ }
+
+
+LTC6802::Status LTC6802StackBase::readValues(const byte cmd, const byte frameBytes, byte *const frame)
+ {
+  LTC6802::Status status = LTC6802::ok;
+  // Only a conversion into this register group has to finish, the others keep running
+  if (((conversion & 0xf0) == STTMPAD) == (cmd == RDTMP))
+   {
+    status = waitConversion();
+   }
+  if (status == LTC6802::ok)
+   {
+    status = read(cmd, frameBytes, frame);
+   }
+  return status;
+ }
+
+
+LTC6802::Status LTC6802StackBase::waitConversion()
+ {
+  LTC6802::Status status;
+  while ((status = poll()) == LTC6802::busy)
+   {
+    LTC6802_PROFILE_POLL();
+    delayMicroseconds(pollInterval);
+   }
+  return status;
+ }
+
+
+bool LTC6802StackBase::isConversionDone()
+ {
+  // Daisy chain and open drain SDO both report low while any chip is busy, then high or toggling (LVLPL clear)
+  byte frame[2] = {PLADC, PLADC};
+  select();
+  bus.transfer(frame, 2);
+  bus.deselect(csPin);
+  return (frame[1] != 0x00);
+ }
+
+
+bool LTC6802StackBase::isInterruptPending()
+ {
+  // Daisy chain and open drain SDO both report low while any chip has a flag set
+  byte frame[2] = {PLINT, PLINT};
+  select();
+  bus.transfer(frame, 2);
+  bus.deselect(csPin);
+  return (frame[1] == 0x00);
+ }
+
+
+void LTC6802StackBase::levelPollBegin()
+ {
+  byte cmd = PLADC;
+  select();
+  bus.transfer(&cmd, 1);
+  bus.suspend(csPin);
+ }
+
+
+void LTC6802StackBase::levelPollEnd()
+ {
+  bus.resume(csPin);
+  bus.deselect(csPin);
+ }
+
+
+LTC6802::Status LTC6802StackBase::poll()
+ {
+  if (!converting)
+   {
+    return LTC6802::ok;
+   }
+  if (isConversionDone())
+   {
+    converting = false;
+    return LTC6802::ok;
+   }
+  if ((micros() - conversionStart) > conversionTimeout)
+   {
+    converting = false;
+    return LTC6802::timeout;
+   }
+  return LTC6802::busy;
+ }
+
+
+void LTC6802StackBase::setConversionTimeout(const unsigned long timeout)
+ {
+  conversionTimeout = timeout;
+ }
+
+
+void LTC6802StackBase::setRetries(const byte retries)
+ {
+  this->retries = retries;
+ }
+
+
+byte LTC6802StackBase::getPecErrors(const byte chip) const
+ {
+  return ERR[chip];
+ }
+
+
+void LTC6802StackBase::resetPecErrors()
+ {
+  for (byte chip = 0; chip < numChips; ++chip)
+   {
+    ERR[chip] = 0;
+   }
+ }
+
+
+LTC6802::Status LTC6802StackBase::cfgRead()
+ {
+  LTC6802_PROFILE_SCOPE(stackCfgRead);
+  return read(RDCFG, cfgFrameBytes, CFG);
+ }
+
+
+void LTC6802StackBase::select()
+ {
+  bus.select(csPin);
+  lastActivity = millis();
+ }
+
+
+void LTC6802StackBase::cfgWrite()
+ {
+  LTC6802_PROFILE_SCOPE(stackCfgWrite);
+  if (firstAddress != 0)
+   {
+    for (byte chip = 0; chip < numChips; ++chip)
+     {
+      cfgWriteChip(chip, firstAddress + chip);
+     }
+    return;
+   }
+  // Copies, because transfers overwrite the sent bytes with the received ones
+  byte buf[LTC6802::cfgRegisters];
+  select();
+  buf[0] = WRCFG;
+  bus.transfer(buf, 1);
+  // Configuration is shifted up the chain, so the top chip goes first (no PEC, it would shift into the next chip)
+  for (int chip = numChips - 1; chip >= 0; --chip)
+   {
+    for (int i = 0; i < LTC6802::cfgRegisters; ++i)
+     {
+      buf[i] = SHD[chip * cfgFrameBytes + i] = CFG[chip * cfgFrameBytes + i];
+     }
+    bus.transfer(buf, LTC6802::cfgRegisters);
+   }
+  bus.deselect(csPin);
+ }
+
+
+void LTC6802StackBase::cfgWriteChip(const byte chip, const byte address)
+ {
+  const byte *const cfg = &CFG[chip * cfgFrameBytes];
+  byte buf[2 + cfgFrameBytes];
+  buf[0] = address;
+  buf[1] = WRCFG;
+  for (int i = 0; i < LTC6802::cfgRegisters; ++i)
+   {
+    buf[2 + i] = cfg[i];
+   }
+  buf[2 + LTC6802::cfgRegisters] = LTC6802PEC::calculate(cfg, LTC6802::cfgRegisters);
+  select();
+  if (address == 0)
+   {
+    // Broadcast without address byte
+    bus.transfer(&buf[1], sizeof(buf) - 1);
+   }
+  else
+   {
+    bus.transfer(buf, sizeof(buf));
+   }
+  bus.deselect(csPin);
+  for (byte target = 0; target < numChips; ++target)
+   {
+    if ((address == 0) || (target == chip))
+     {
+      for (int i = 0; i < LTC6802::cfgRegisters; ++i)
+       {
+        SHD[target * cfgFrameBytes + i] = cfg[i];
+       }
+     }
+   }
+ }
+
+
+bool LTC6802StackBase::cfgChanged(const byte chip) const
+ {
+  const byte *const cfg = &CFG[chip * cfgFrameBytes];
+  const byte *const shd = &SHD[chip * cfgFrameBytes];
+  // WDT is read only
+  bool changed = ((cfg[0] ^ shd[0]) & CFG0_WDT_INVMSK) != 0;
+  for (int i = 1; i < LTC6802::cfgRegisters; ++i)
+   {
+    changed |= (cfg[i] != shd[i]);
+   }
+  return changed;
+ }
+
+
+byte LTC6802StackBase::cfgUpdate()
+ {
+  LTC6802_PROFILE_SCOPE(stackCfgUpdate);
+  byte changed = 0;
+  bool identical = true;
+  for (byte chip = 0; chip < numChips; ++chip)
+   {
+    if (cfgChanged(chip))
+     {
+      ++changed;
+     }
+    const byte *const cfg = &CFG[chip * cfgFrameBytes];
+    identical &= ((cfg[0] ^ CFG[0]) & CFG0_WDT_INVMSK) == 0;
+    for (int i = 1; i < LTC6802::cfgRegisters; ++i)
+     {
+      identical &= (cfg[i] == CFG[i]);
+     }
+   }
+  if (changed == 0)
+   {
+    return 0;
+   }
+  if (firstAddress == 0)
+   {
+    // A daisy chain is always written as a whole
+    cfgWrite();
+    return 1;
+   }
+  if (identical)
+   {
+    cfgWriteChip(0, 0);
+    return 1;
+   }
+  for (byte chip = 0; chip < numChips; ++chip)
+   {
+    if (cfgChanged(chip))
+     {
+      cfgWriteChip(chip, firstAddress + chip);
+     }
+   }
+  return changed;
+ }
+
+
+LTC6802::Status LTC6802StackBase::cfgVerify()
+ {
+  // Read what the chips really hold into the shadow, so a reset chip shows up as changed
+  const LTC6802::Status status = read(RDCFG, cfgFrameBytes, SHD);
+  if (status != LTC6802::ok)
+   {
+    for (byte chip = 0; chip < numChips; ++chip)
+     {
+      SHD[chip * cfgFrameBytes + 1] = ~CFG[chip * cfgFrameBytes + 1];
+     }
+   }
+  return status;
+ }
+
+
+void LTC6802StackBase::keepAlive()
+ {
+  LTC6802_PROFILE_SCOPE(stackKeepAlive);
+  const unsigned long now = millis();
+  if ((verifyInterval != 0) && ((now - lastVerify) >= verifyInterval))
+   {
+    lastVerify = now;
+    cfgVerify();
+   }
+  if ((cfgUpdate() == 0) && ((now - lastActivity) >= keepAliveInterval))
+   {
+    // Cheapest valid traffic: a single broadcast poll command byte
+    byte cmd = PLADC;
+    select();
+    bus.transfer(&cmd, 1);
+    bus.deselect(csPin);
+   }
+ }
+
+
+void LTC6802StackBase::setKeepAliveInterval(const unsigned long interval)
+ {
+  keepAliveInterval = interval;
+ }
+
+
+void LTC6802StackBase::setVerifyInterval(const unsigned long interval)
+ {
+  verifyInterval = interval;
+ }
+
+
+byte *LTC6802StackBase::cfg(const byte chip)
+ {
+  return &CFG[chip * cfgFrameBytes];
+ }
+
+
+const byte *LTC6802StackBase::cfg(const byte chip) const
+ {
+  return &CFG[chip * cfgFrameBytes];
+ }
+
+
+void LTC6802StackBase::cellsMeasure(const bool discharge)
+ {
+  LTC6802_PROFILE_SCOPE(stackCellsMeasure);
+  measure(discharge ? STCDC : STCVAD);
+ }
+
+
+LTC6802::Status LTC6802StackBase::cellsRead()
+ {
+  LTC6802_PROFILE_SCOPE(stackCellsRead);
+  const LTC6802::Status status = readValues(RDCV, cellFrameBytes, CV);
+  if (status == LTC6802::ok)
+   {
+    updateStats();
+   }
+  return status;
+ }
+
+
+LTC6802::Status LTC6802StackBase::scanRead()
+ {
+  LTC6802_PROFILE_SCOPE(stackScanRead);
+  LTC6802::Status status = waitConversion();
+  if (status != LTC6802::ok)
+   {
+    return status;
+   }
+  const Group groups[] = {{RDCV, cellFrameBytes, CV}, {RDTMP, tmpFrameBytes, TMP}, {RDFLG, flgFrameBytes, FLG}};
+  status = readGroups(groups, sizeof(groups) / sizeof(groups[0]));
+  if (status == LTC6802::ok)
+   {
+    updateStats();
+   }
+  return status;
+ }
+
+
+void LTC6802StackBase::updateStats()
+ {
+  if (stats == 0)
+   {
+    return;
+   }
+  stats->begin();
+  for (byte chip = 0; chip < numChips; ++chip)
+   {
+    const byte *const cv = &CV[chip * cellFrameBytes];
+    // Cells come in pairs, 10 cell chips skip the last pair
+    for (byte reg = 0; reg < cellsPerChip / 2 * 3; reg += 3)
+     {
+      const uint32_t lanes = LTC6802::cellsDecodePair(&cv[reg], true);
+      stats->add((uint16_t)lanes);
+      stats->add((uint16_t)(lanes >> 16));
+     }
+   }
+  stats->end();
+ }
+
+
+void LTC6802StackBase::cellMeasure(const byte cell)
+ {
+  measure(STCVAD | (cell + 1));
+ }
+
+
+LTC6802::Status LTC6802StackBase::cellRead(const byte cell, uint16_t *const millivolts)
+ {
+  const LTC6802::Status status = readValues(RDCV, cellFrameBytes, CV);
+  if (status == LTC6802::ok)
+   {
+    for (byte chip = 0; chip < numChips; ++chip)
+     {
+      millivolts[chip * LTC6802::maxCells + cell] = LTC6802::cellDecode(&CV[chip * cellFrameBytes], cell, true);
+     }
+   }
+  return status;
+ }
+
+
+void LTC6802StackBase::openWireMeasure(const bool discharge)
+ {
+  measure(discharge ? STOWDC : STOWAD);
+ }
+
+
+LTC6802::Status LTC6802StackBase::openWireRead(uint16_t *const codes)
+ {
+  const LTC6802::Status status = readValues(RDCV, cellFrameBytes, CV);
+  if (status == LTC6802::ok)
+   {
+    cellsGetCodes(codes);
+   }
+  return status;
+ }
+
+
+void LTC6802StackBase::selfTestMeasure(const byte test)
+ {
+  measure(((test & 2) ? STTMPAD : STCVAD) | ((test & 1) ? 0x0f : 0x0e));
+ }
+
+
+LTC6802::Status LTC6802StackBase::selfTestRead(const byte test, byte *const frame)
+ {
+  const LTC6802::Status status = poll();
+  if (status != LTC6802::ok)
+   {
+    return status;
+   }
+  // Separate frame, the registers of the stack keep the last measurement
+  return (test & 2) ? read(RDTMP, tmpFrameBytes, frame + 1) : read(RDCV, cellFrameBytes, frame + 1);
+ }
+
+
+bool LTC6802StackBase::selfTestCheck(const byte test, const byte chip, const byte *const frame) const
+ {
+  // Both patterns in two 12 bit lanes, compared a word at a time
+  const uint32_t lanes = (test & 1) ? 0x0aaa0aaaUL : 0x05550555UL;
+  uint32_t diff;
+  if (test & 2)
+   {
+    // ETMP1, ETMP2 are packed like a cell pair; ITMP below THSD and REV
+    const byte *const arr = &frame[1 + chip * tmpFrameBytes];
+    diff = (LTC6802::cellsDecodePair(arr, false) ^ lanes) | ((arr[3] | ((uint32_t)(arr[4] & 0x0f) << 8)) ^ (lanes & 0x0fff));
+   }
+  else
+   {
+    const byte *const arr = &frame[1 + chip * cellFrameBytes];
+    diff = 0;
+    const byte regs = (CFG[chip * cfgFrameBytes] & CFG0_CELL10_MSK) ? (LTC6802::cellRegisters - 3) : LTC6802::cellRegisters;
+    for (byte reg = 0; reg < regs; reg += 3)
+     {
+      diff |= LTC6802::cellsDecodePair(&arr[reg], false) ^ lanes;
+     }
+   }
+  return (diff == 0);
+ }
+
+
+const byte *LTC6802StackBase::cells(const byte chip) const
+ {
+  return &CV[chip * cellFrameBytes];
+ }
+
+
+void LTC6802StackBase::cellsGetCodes(uint16_t *const codes) const
+ {
+  for (byte chip = 0; chip < numChips; ++chip)
+   {
+    LTC6802::cellsDecode(&CV[chip * cellFrameBytes], &codes[chip * LTC6802::maxCells], false);
+   }
+ }
+
+
+void LTC6802StackBase::cellsGetMillivolts(uint16_t *const millivolts) const
+ {
+  for (byte chip = 0; chip < numChips; ++chip)
+   {
+    LTC6802::cellsDecode(&CV[chip * cellFrameBytes], &millivolts[chip * LTC6802::maxCells], true);
+   }
+ }
+
+
+void LTC6802StackBase::setStats(LTC6802Stats *const stats)
+ {
+  this->stats = stats;
+ }
+
+
+void LTC6802StackBase::temperatureMeasure()
+ {
+  LTC6802_PROFILE_SCOPE(stackTemperatureMeasure);
+  measure(STTMPAD);
+ }
+
+
+LTC6802::Status LTC6802StackBase::temperatureRead()
+ {
+  LTC6802_PROFILE_SCOPE(stackTemperatureRead);
+  return readValues(RDTMP, tmpFrameBytes, TMP);
+ }
+
+
+const byte *LTC6802StackBase::temperatures(const byte chip) const
+ {
+  return &TMP[chip * tmpFrameBytes];
+ }
+
+
+LTC6802::Status LTC6802StackBase::flagsRead()
+ {
+  LTC6802_PROFILE_SCOPE(stackFlagsRead);
+  return read(RDFLG, flgFrameBytes, FLG);
+ }
+
+
+unsigned long LTC6802StackBase::calibrateClock(const unsigned long minClock, const unsigned long maxClock, const byte reads)
+ {
+  const byte savedRetries = retries;
+  retries = 0;
+  unsigned long best = minClock;
+  for (unsigned long hz = minClock; hz <= maxClock; hz *= 2)
+   {
+    bus.setClock(hz);
+    bool reliable = true;
+    for (byte i = 0; reliable && (i < reads); ++i)
+     {
+      reliable = (flagsRead() == LTC6802::ok);
+     }
+    if (!reliable)
+     {
+      break;
+     }
+    best = hz;
+    if (hz > maxClock / 2)
+     {
+      break;
+     }
+   }
+  bus.setClock(best);
+  retries = savedRetries;
+  return best;
+ }
+
+
+const byte *LTC6802StackBase::flags(const byte chip) const
+ {
+  return &FLG[chip * flgFrameBytes];
+ }
+
+
+void LTC6802StackBase::flagsGet(const byte chip, word &overvoltage, word &undervoltage) const
+ {
+  LTC6802::flagsDecode(&FLG[chip * flgFrameBytes], overvoltage, undervoltage);
+ }
@@ -0,0 +1,868 @@
+/**
+ * Copyright 2017, 2019 Dipl.-Inform. Kai Hofmann
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef LTC6802STACK_H_INCLUDED_
+  #define LTC6802STACK_H_INCLUDED_
+
+  #include <LTC6802.h>
+
+  /**
+   * Battery stack monitor for multiple LTC6802 chips on one bus.
+   *
+   * LTC6802-1 daisy chain: all chips of the chain share one chip select.
+   * Every register group is clocked out of the whole chain in a single
+   * frame into one contiguous buffer, chip 0 being the bottom chip
+   * connected to the MCU.
+   *
+   * LTC6802-2 addressed chips: conversions are started once by broadcast,
+   * so all chips sample at the same instant, then the register groups are
+   * read chip after chip into the same buffer layout.
+   *
+   * Chip count and register buffer are runtime values; LTC6802Stack<NumChips, CellsPerChip>
+   * below fixes both at compile time and owns the registers.
+   *
+   * https://www.analog.com/media/en/technical-documentation/data-sheets/LTC6802-1.pdf
+   * https://cds.linear.com/docs/en/datasheet/68022fa.pdf
+   */
+  class LTC6802StackBase
+   {
+    public:
+      /**
+       * Bytes per chip in the configuration frame (registers and PEC).
+       */
+      static const byte cfgFrameBytes = LTC6802::cfgRegisters + 1;
+
+      /**
+       * Bytes per chip in the cell voltage frame (registers and PEC).
+       */
+      static const byte cellFrameBytes = LTC6802::cellRegisters + 1;
+
+      /**
+       * Bytes per chip in the temperature frame (registers and PEC).
+       */
+      static const byte tmpFrameBytes = LTC6802::tmpRegisters + 1;
+
+      /**
+       * Bytes per chip in the flag frame (registers and PEC).
+       */
+      static const byte flgFrameBytes = LTC6802::flgRegisters + 1;
+
+      /**
+       * Register buffer size needed per chip (frames, configuration shadow and PEC error counter).
+       */
+      static const byte chipBufferBytes = cfgFrameBytes + cellFrameBytes + tmpFrameBytes + flgFrameBytes + cfgFrameBytes + 1;
+
+      /**
+       * Command bytes in front of the register group frames and the configuration shadow.
+       */
+      static const byte frameHeaderBytes = 5;
+
+      /**
+       * Register buffer size needed for a stack.
+       *
+       * @param numChips Number of chips
+       * @return Bytes
+       */
+      static constexpr unsigned int bufferSize(const byte numChips) {return (unsigned int)numChips * chipBufferBytes + frameHeaderBytes;}
+
+      /**
+       * Constructor for a LTC6802-1 daisy chain.
+       *
+       * @param bus Transport the chain is connected to
+       * @param csPin Chip select pin of the bottom chip
+       * @param numChips Number of chips in the chain
+       * @param buffer Register buffer of bufferSize(numChips) bytes
+       */
+      LTC6802StackBase(LTC6802Transport &bus, byte csPin, byte numChips, byte *buffer);
+
+      /**
+       * Constructor for LTC6802-2 chips with consecutive addresses.
+       *
+       * @param bus Transport the chips are connected to
+       * @param csPin Common chip select pin
+       * @param firstAddress Address of chip 0 (e.g. 0x80)
+       * @param numChips Number of chips
+       * @param buffer Register buffer of bufferSize(numChips) bytes
+       */
+      LTC6802StackBase(LTC6802Transport &bus, byte csPin, byte firstAddress, byte numChips, byte *buffer);
+
+      /**
+       * Get number of chips.
+       *
+       * @return Number of chips
+       */
+      byte getNumChips() const;
+
+      /**
+       * Get number of cells per chip.
+       *
+       * @return 10 or 12
+       */
+      byte getCellsPerChip() const;
+
+      /**
+       * Read configuration of all chips.
+       *
+       * @return ok; pecError
+       */
+      LTC6802::Status cfgRead();
+
+      /**
+       * Write configuration to all chips.
+       *
+       * Addressed chips get the configuration followed by its PEC.
+       */
+      void cfgWrite();
+
+      /**
+       * Write only configurations that differ from what the chips hold.
+       *
+       * Identical configurations of addressed chips are coalesced into one
+       * broadcast write, a daisy chain is written as a whole.
+       *
+       * @return Number of write frames sent
+       */
+      byte cfgUpdate();
+
+      /**
+       * Read what the chips hold into the shadow of the written configuration.
+       *
+       * The configuration set through cfg() stays untouched, the next
+       * cfgUpdate() rewrites chips that lost or changed theirs.
+       *
+       * @return ok; pecError (all chips are considered changed)
+       */
+      LTC6802::Status cfgVerify();
+
+      /**
+       * Keep the configuration alive with minimal bus traffic; call every loop.
+       *
+       * Re-reads the chip configurations on the verify interval, writes
+       * changed configurations and otherwise sends a single command byte when
+       * the bus was idle for the keep alive interval, so the watchdog (2.5s)
+       * never resets the chips.
+       */
+      void keepAlive();
+
+      /**
+       * Set bus idle time after which keepAlive() sends traffic.
+       *
+       * @param interval Milliseconds (default 2000)
+       */
+      void setKeepAliveInterval(unsigned long interval);
+
+      /**
+       * Set cadence of configuration read back in keepAlive().
+       *
+       * @param interval Milliseconds, 0 : never (default 10000)
+       */
+      void setVerifyInterval(unsigned long interval);
+
+      /**
+       * Get configuration registers of a chip.
+       *
+       * @param chip Chip index, 0 : bottom chip
+       * @return 6 configuration registers
+       */
+      byte *cfg(byte chip);
+
+      /**
+       * Get configuration registers of a chip.
+       *
+       * @param chip Chip index, 0 : bottom chip
+       * @return 6 configuration registers
+       */
+      const byte *cfg(byte chip) const;
+
+      /**
+       * Measure cell voltages on all chips.
+       *
+       * @param discharge true : discharge switches stay as configured (STCDC); false : discharge off during conversion (STCVAD)
+       */
+      void cellsMeasure(bool discharge = false);
+
+      /**
+       * Read cell voltages from all chips.
+       *
+       * Waits for a running cell conversion first, a running temperature conversion continues.
+       *
+       * @return ok; timeout when the conversion did not finish (registers are not read); pecError
+       */
+      LTC6802::Status cellsRead();
+
+      /**
+       * Measure a single cell voltage on all chips.
+       *
+       * Converts in about 1/12 of the time of all cells.
+       *
+       * @param cell Cell index 0-11 within each chip
+       */
+      void cellMeasure(byte cell);
+
+      /**
+       * Read a single cell voltage from all chips.
+       *
+       * Waits for a running cell conversion first. The register groups are
+       * read completely to keep the PEC check; the other cells keep their
+       * values. Pack statistics are not fed.
+       *
+       * @param cell Cell index 0-11 within each chip
+       * @param millivolts Array for numChips * 12 voltages in mV, chip 0 first; only the entries of cell are written
+       * @return ok; timeout when the conversion did not finish (registers are not read); pecError
+       */
+      LTC6802::Status cellRead(byte cell, uint16_t *millivolts);
+
+      /**
+       * Measure cell voltages on all chips with open-wire detection currents.
+       *
+       * @param discharge true : discharge permitted (STOWDC); false : discharge off during conversion (STOWAD)
+       */
+      void openWireMeasure(bool discharge = false);
+
+      /**
+       * Read open-wire cell voltages from all chips.
+       *
+       * Waits for a running cell conversion first. The cell voltage registers
+       * hold open-wire results afterwards; pack statistics are not fed.
+       *
+       * @param codes Array for numChips * 12 codes (1.5mV per count), chip 0 first
+       * @return ok; timeout when the conversion did not finish (registers are not read); pecError
+       */
+      LTC6802::Status openWireRead(uint16_t *codes);
+
+      /**
+       * Start an A/D self test conversion on all chips.
+       *
+       * @param test 0 : cells 0x555; 1 : cells 0xaaa; 2 : temperatures 0x555; 3 : temperatures 0xaaa
+       */
+      void selfTestMeasure(byte test);
+
+      /**
+       * Read the result of an A/D self test conversion of all chips.
+       *
+       * Does not wait: while the conversion runs nothing is read. The result
+       * goes to a separate frame, the registers of the stack are not changed.
+       *
+       * @param test 0 : cells 0x555; 1 : cells 0xaaa; 2 : temperatures 0x555; 3 : temperatures 0xaaa
+       * @param frame Frame buffer of selfTestFrameSize(numChips) bytes
+       * @return ok; busy while converting; timeout; pecError
+       */
+      LTC6802::Status selfTestRead(byte test, byte *frame);
+
+      /**
+       * Check the self test pattern of one chip read by selfTestRead().
+       *
+       * @param test Test of the read
+       * @param chip Chip index, 0 : bottom chip
+       * @param frame Frame buffer passed to selfTestRead()
+       * @return true if the pattern matched
+       */
+      bool selfTestCheck(byte test, byte chip, const byte *frame) const;
+
+      /**
+       * Get size of the frame buffer for selfTestRead().
+       *
+       * @param numChips Number of chips
+       * @return Bytes
+       */
+      static constexpr unsigned int selfTestFrameSize(const byte numChips) {return 1U + (unsigned int)numChips * cellFrameBytes;}
+
+      /**
+       * Get cell voltage registers of a chip.
+       *
+       * @param chip Chip index, 0 : bottom chip
+       * @return 18 cell voltage registers
+       */
+      const byte *cells(byte chip) const;
+
+      /**
+       * Get raw cell voltage A/D codes of all chips in one pass.
+       *
+       * @param codes Array for numChips * 12 codes (1.5mV per count), chip 0 first
+       */
+      void cellsGetCodes(uint16_t *codes) const;
+
+      /**
+       * Get cell voltages of all chips in one pass.
+       *
+       * @param millivolts Array for numChips * 12 voltages in mV, chip 0 first
+       */
+      void cellsGetMillivolts(uint16_t *millivolts) const;
+
+      /**
+       * Attach pack statistics fed by every successful cellsRead().
+       *
+       * Cells are numbered chip * getCellsPerChip() + cell.
+       *
+       * @param stats Statistics, 0 to detach
+       */
+      void setStats(LTC6802Stats *stats);
+
+      /**
+       * Measure temperatures on all chips.
+       */
+      void temperatureMeasure();
+
+      /**
+       * Read temperatures from all chips.
+       *
+       * Waits for a running temperature conversion first, a running cell conversion continues.
+       *
+       * @return ok; timeout when the conversion did not finish (registers are not read); pecError
+       */
+      LTC6802::Status temperatureRead();
+
+      /**
+       * Get temperature registers of a chip.
+       *
+       * @param chip Chip index, 0 : bottom chip
+       * @return 5 temperature registers
+       */
+      const byte *temperatures(byte chip) const;
+
+      /**
+       * Poll A/D converter status of all chips once (broadcast PLADC).
+       *
+       * With toggle polling (LVLPL clear, the reset default) SDO toggles at
+       * 1kHz after the conversion, so a poll in its low half still reads busy.
+       *
+       * @return true if no chip is converting
+       */
+      bool isConversionDone();
+
+      /**
+       * Poll comparator interrupt status of all chips at once (PLINT).
+       *
+       * @return true if an unmasked cell of any chip is flagged over or under voltage
+       */
+      bool isInterruptPending();
+
+      /**
+       * Start level polling of the running conversion (LVLPL set in all chips).
+       *
+       * Chip select stays low after PLADC, SDO goes high when all chips are done,
+       * so a pin change interrupt can wait for it. The bus must not be used until levelPollEnd().
+       */
+      void levelPollBegin();
+
+      /**
+       * End level polling and release chip select.
+       */
+      void levelPollEnd();
+
+      /**
+       * Check progress of the last started conversion without blocking.
+       *
+       * @return ok : finished or none started; busy : still running; timeout : exceeded conversion timeout
+       */
+      LTC6802::Status poll();
+
+      /**
+       * Set the time after which a conversion is reported as failed.
+       *
+       * @param timeout Microseconds (default 20000)
+       */
+      void setConversionTimeout(unsigned long timeout);
+
+      /**
+       * Read flag register groups from all chips.
+       *
+       * @return ok; pecError
+       */
+      LTC6802::Status flagsRead();
+
+      /**
+       * Read cell, temperature and flag register groups from all chips at once.
+       *
+       * Waits for a running conversion first. All frames go to the transport
+       * as one batch, so a batching transport (LTC6802SpidevTransport) reads
+       * the whole stack with one bus call; chips failing the PEC check are
+       * read again in the retries.
+       *
+       * @return ok; timeout when the conversion did not finish (registers are not read); pecError
+       */
+      LTC6802::Status scanRead();
+
+      /**
+       * Set number of automatic retries of a read that failed the PEC check.
+       *
+       * A daisy chain frame is read again as a whole, addressed chips one by one.
+       *
+       * @param retries Retries (default 0)
+       */
+      void setRetries(byte retries);
+
+      /**
+       * Get number of reads of a chip that failed the PEC check.
+       *
+       * @param chip Chip index, 0 : bottom chip
+       * @return Error counter, saturates at 255
+       */
+      byte getPecErrors(byte chip) const;
+
+      /**
+       * Reset PEC error counters of all chips.
+       */
+      void resetPecErrors();
+
+      /**
+       * Find the fastest SPI clock rate the wiring transfers without PEC errors.
+       *
+       * Starting at minClock the bus clock is doubled as long as a number of
+       * flag register reads all pass the PEC check and maxClock is not exceeded.
+       * The bus is left at the fastest reliable rate. Failed reads count
+       * toward getPecErrors() and overwrite the flag registers.
+       *
+       * @param minClock Start clock rate in Hz
+       * @param maxClock Highest clock rate to try in Hz
+       * @param reads Reads per clock rate
+       * @return Selected clock rate in Hz
+       */
+      unsigned long calibrateClock(unsigned long minClock, unsigned long maxClock, byte reads = 32);
+
+      /**
+       * Get flag registers of a chip.
+       *
+       * @param chip Chip index, 0 : bottom chip
+       * @return 3 flag registers
+       */
+      const byte *flags(byte chip) const;
+
+      /**
+       * Get the comparator flags of a chip from the last flagsRead().
+       *
+       * @param chip Chip index, 0 : bottom chip
+       * @param overvoltage bit n : cell n+1 above VOV
+       * @param undervoltage bit n : cell n+1 below VUV
+       */
+      void flagsGet(byte chip, word &overvoltage, word &undervoltage) const;
+
+    protected:
+      /**
+       * Constructor with separate register frames.
+       *
+       * Every frame starts with a command byte, followed by numChips frames
+       * of registers and PEC.
+       *
+       * @param bus Transport the chips are connected to
+       * @param csPin Chip select pin
+       * @param firstAddress Address of chip 0, 0 for a daisy chain
+       * @param numChips Number of chips
+       * @param cellsPerChip 10 (CELL10 mode) or 12
+       * @param cfg Configuration frame of 1 + numChips * cfgFrameBytes
+       * @param cv Cell voltage frame of 1 + numChips * cellFrameBytes
+       * @param tmp Temperature frame of 1 + numChips * tmpFrameBytes
+       * @param flg Flag frame of 1 + numChips * flgFrameBytes
+       * @param shd Configuration shadow of 1 + numChips * cfgFrameBytes
+       * @param err PEC error counters of numChips
+       */
+      LTC6802StackBase(LTC6802Transport &bus, byte csPin, byte firstAddress, byte numChips, byte cellsPerChip,
+                       byte *cfg, byte *cv, byte *tmp, byte *flg, byte *shd, byte *err);
+
+      // Disable heap allocation
+      static void *operator new (size_t) throw() {return (0);}
+      static void operator delete (void *) throw() {}
+
+    private:
+      /**
+       * Transport the chain is connected to.
+       */
+      LTC6802Transport &bus;
+
+      /**
+       * Chip select pin.
+       */
+      byte csPin;
+
+      /**
+       * Address of chip 0, 0 for a daisy chain.
+       */
+      byte firstAddress;
+
+      /**
+       * Number of chips.
+       */
+      byte numChips;
+
+      /**
+       * Cells per chip, 10 or 12.
+       */
+      byte cellsPerChip;
+
+      /**
+       * Configuration frame, numChips * cfgFrameBytes, preceded by a command byte.
+       */
+      byte *CFG;
+
+      /**
+       * Cell voltage frame, numChips * cellFrameBytes, preceded by a command byte.
+       */
+      byte *CV;
+
+      /**
+       * Temperature frame, numChips * tmpFrameBytes, preceded by a command byte.
+       */
+      byte *TMP;
+
+      /**
+       * Flag frame, numChips * flgFrameBytes, preceded by a command byte.
+       */
+      byte *FLG;
+
+      /**
+       * Configuration the chips hold as far as known, numChips * cfgFrameBytes, preceded by a command byte.
+       */
+      byte *SHD;
+
+      /**
+       * PEC error counters, one per chip.
+       */
+      byte *ERR;
+
+      /**
+       * Time of the last frame in milliseconds.
+       */
+      unsigned long lastActivity = 0;
+
+      /**
+       * Time of the last configuration read back in milliseconds.
+       */
+      unsigned long lastVerify = 0;
+
+      /**
+       * Bus idle time after which keepAlive() sends traffic.
+       */
+      unsigned long keepAliveInterval = 2000;
+
+      /**
+       * Cadence of configuration read back.
+       */
+      unsigned long verifyInterval = 10000;
+
+      /**
+       * Pack statistics fed by cellsRead().
+       */
+      LTC6802Stats *stats = 0;
+
+      /**
+       * Automatic retries of reads that failed the PEC check.
+       */
+      byte retries = 0;
+
+      /**
+       * Conversion started and not yet reported as finished.
+       */
+      bool converting = false;
+
+      /**
+       * Command of the last started conversion.
+       */
+      byte conversion = 0;
+
+      /**
+       * Start time of the last conversion in microseconds.
+       */
+      unsigned long conversionStart = 0;
+
+      /**
+       * Conversion timeout in microseconds.
+       */
+      unsigned long conversionTimeout = 20000;
+
+      /**
+       * Pause between two PLADC polls while blocking, in microseconds.
+       */
+      static const unsigned int pollInterval = 250;
+
+      /**
+       * Begin a frame and note the bus activity.
+       */
+      void select();
+
+      /**
+       * Write configuration of one chip, followed by its PEC.
+       *
+       * @param chip Chip index
+       * @param address Chip address, 0 : broadcast to all chips
+       */
+      void cfgWriteChip(byte chip, byte address);
+
+      /**
+       * Check whether a configuration differs from what the chip holds.
+       *
+       * @param chip Chip index
+       * @return true if a write is needed
+       */
+      bool cfgChanged(byte chip) const;
+
+      /**
+       * Send command to all chips as broadcast.
+       *
+       * @param cmd Chip command
+       */
+      void measure(byte cmd);
+
+      /**
+       * Read one register group from all chips, retrying on PEC errors.
+       *
+       * @param cmd Read command
+       * @param frameBytes Bytes per chip including PEC
+       * @param frame Frame buffer of numChips * frameBytes
+       * @return ok; pecError
+       */
+      LTC6802::Status read(byte cmd, byte frameBytes, byte *frame);
+
+      /**
+       * Register group read by readGroups().
+       */
+      struct Group
+       {
+        /**
+         * Read command.
+         */
+        byte cmd;
+
+        /**
+         * Bytes per chip including PEC.
+         */
+        byte frameBytes;
+
+        /**
+         * Frame buffer of numChips * frameBytes.
+         */
+        byte *frame;
+       };
+
+      /**
+       * Read register groups from all chips as one transport batch, retrying on PEC errors.
+       *
+       * @param groups Register groups
+       * @param count Number of groups
+       * @return ok; pecError
+       */
+      LTC6802::Status readGroups(const Group *groups, byte count);
+
+      /**
+       * Queue the frames of one register group.
+       *
+       * @param group Register group
+       * @param all true : all chips, false : only chips failing the PEC check
+       * @param deferred Transport defers the frames until flush()
+       */
+      void queueGroup(const Group &group, bool all, bool deferred);
+
+      /**
+       * Check PEC of one chip and count errors.
+       *
+       * @param chip Chip index
+       * @param frameBytes Bytes including PEC
+       * @param arr Register group of the chip followed by its PEC
+       * @return true if the PEC matches
+       */
+      bool checkPec(byte chip, byte frameBytes, const byte *arr);
+
+      /**
+       * Read one register group from an addressed chip.
+       *
+       * @param chip Chip index
+       * @param cmd Read command
+       * @param frameBytes Bytes including PEC
+       * @param arr Array for frameBytes bytes
+       */
+      void readChip(byte chip, byte cmd, byte frameBytes, byte *arr);
+
+      /**
+       * Read one register group of a single chip from a daisy chain.
+       *
+       * Clocks out the chain only up to the chip.
+       *
+       * @param chip Chip index
+       * @param cmd Read command
+       * @param frameBytes Bytes including PEC
+       * @param arr Array for frameBytes bytes
+       */
+      void readChainChip(byte chip, byte cmd, byte frameBytes, byte *arr);
+
+      /**
+       * Read register group after the running conversion finished.
+       *
+       * @param cmd Read command
+       * @param frameBytes Bytes per chip including PEC
+       * @param frame Frame buffer of numChips * frameBytes
+       * @return ok; timeout when the conversion did not finish; pecError
+       */
+      LTC6802::Status readValues(byte cmd, byte frameBytes, byte *frame);
+
+      /**
+       * Poll until the running conversion finished.
+       *
+       * @return ok; timeout
+       */
+      LTC6802::Status waitConversion();
+
+      /**
+       * Feed the cell voltages to the pack statistics, if set.
+       */
+      void updateStats();
+
+   };
+
+  /**
+   * Register storage of a stack, one array per register group (struct of arrays).
+   *
+   * Every array starts with the command byte of the frame.
+   */
+  template <byte NumChips> struct LTC6802StackRegisters
+   {
+    /**
+     * Configuration frame.
+     */
+    byte cfgFrame[1 + NumChips * LTC6802StackBase::cfgFrameBytes];
+
+    /**
+     * Cell voltage frame.
+     */
+    byte cvFrame[1 + NumChips * LTC6802StackBase::cellFrameBytes];
+
+    /**
+     * Temperature frame.
+     */
+    byte tmpFrame[1 + NumChips * LTC6802StackBase::tmpFrameBytes];
+
+    /**
+     * Flag frame.
+     */
+    byte flgFrame[1 + NumChips * LTC6802StackBase::flgFrameBytes];
+
+    /**
+     * Configuration shadow.
+     */
+    byte shdFrame[1 + NumChips * LTC6802StackBase::cfgFrameBytes];
+
+    /**
+     * PEC error counters.
+     */
+    byte errCounters[NumChips];
+   };
+
+  /**
+   * Stack with chip count and cell mode fixed at compile time.
+   *
+   * Owns its registers, no buffer has to be supplied. 10 cell chips run in
+   * CELL10 mode; their unused cells are neither decoded nor counted. The
+   * typed getters decode with loop bounds known at compile time.
+   *
+   * @tparam NumChips Number of chips
+   * @tparam CellsPerChip 10 or 12
+   */
+  template <byte NumChips, byte CellsPerChip = 12> class LTC6802Stack : private LTC6802StackRegisters<NumChips>, public LTC6802StackBase
+   {
+    static_assert(NumChips > 0, "A stack needs at least one chip");
+    static_assert((CellsPerChip == 10) || (CellsPerChip == 12), "LTC6802 chips measure 10 or 12 cells");
+
+    public:
+      /**
+       * Number of chips.
+       */
+      static const byte chipCount = NumChips;
+
+      /**
+       * Cells per chip.
+       */
+      static const byte cellCount = CellsPerChip;
+
+      /**
+       * Constructor for a LTC6802-1 daisy chain.
+       *
+       * @param bus Transport the chain is connected to
+       * @param csPin Chip select pin of the bottom chip
+       */
+      LTC6802Stack(LTC6802Transport &bus, const byte csPin)
+       : LTC6802Stack(bus, csPin, 0)
+       {
+       }
+
+      /**
+       * Constructor for LTC6802-2 chips with consecutive addresses.
+       *
+       * @param bus Transport the chips are connected to
+       * @param csPin Common chip select pin
+       * @param firstAddress Address of chip 0 (e.g. 0x80)
+       */
+      LTC6802Stack(LTC6802Transport &bus, const byte csPin, const byte firstAddress)
+       : LTC6802StackRegisters<NumChips>(),
+         LTC6802StackBase(bus, csPin, firstAddress, NumChips, CellsPerChip,
+                          this->LTC6802StackRegisters<NumChips>::cfgFrame, this->LTC6802StackRegisters<NumChips>::cvFrame,
+                          this->LTC6802StackRegisters<NumChips>::tmpFrame, this->LTC6802StackRegisters<NumChips>::flgFrame,
+                          this->LTC6802StackRegisters<NumChips>::shdFrame, this->LTC6802StackRegisters<NumChips>::errCounters)
+       {
+       }
+
+      /**
+       * Registers are owned, copies would share the register pointers of the original.
+       */
+      LTC6802Stack(const LTC6802Stack &) = delete;
+
+      /**
+       * Registers are owned, copies would share the register pointers of the original.
+       */
+      LTC6802Stack &operator=(const LTC6802Stack &) = delete;
+
+      using LTC6802StackBase::cellsGetCodes;
+      using LTC6802StackBase::cellsGetMillivolts;
+
+      /**
+       * Get raw cell voltage A/D codes of all chips.
+       *
+       * @param codes Codes (1.5mV per count)
+       */
+      void cellsGetCodes(uint16_t (&codes)[NumChips][CellsPerChip]) const
+       {
+        decode(codes, false);
+       }
+
+      /**
+       * Get cell voltages of all chips.
+       *
+       * @param millivolts Voltages in mV
+       */
+      void cellsGetMillivolts(uint16_t (&millivolts)[NumChips][CellsPerChip]) const
+       {
+        decode(millivolts, true);
+       }
+
+    private:
+      /**
+       * Decode the used cells of all chips.
+       *
+       * @param values Cell values
+       * @param millivolts true : mV; false : raw A/D codes
+       */
+      void decode(uint16_t (&values)[NumChips][CellsPerChip], const bool millivolts) const
+       {
+        for (byte chip = 0; chip < NumChips; ++chip)
+         {
+          const byte *const cv = &this->LTC6802StackRegisters<NumChips>::cvFrame[1 + chip * cellFrameBytes];
+          for (byte pair = 0; pair < CellsPerChip / 2; ++pair)
+           {
+            const uint32_t lanes = LTC6802::cellsDecodePair(&cv[pair * 3], millivolts);
+            values[chip][2 * pair] = (uint16_t)lanes;
+            values[chip][2 * pair + 1] = (uint16_t)(lanes >> 16);
+           }
+         }
+       }
+   };
+
+#endif
@@ -0,0 +1,105 @@
+/**
+ * Copyright 2017, 2019 Dipl.-Inform. Kai Hofmann
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <LTC6802Stats.h>
+
+
+LTC6802Stats::LTC6802Stats(uint16_t *const ewma, const uint16_t numCells, const byte ewmaShift)
+ : ewma(ewma), numCells(numCells), ewmaShift(ewmaShift)
+ {
+ }
+
+
+void LTC6802Stats::begin()
+ {
+  count = 0;
+  min = 0xffff;
+  minCell = 0;
+  max = 0;
+  maxCell = 0;
+  sum = 0;
+ }
+
+
+void LTC6802Stats::end()
+ {
+  lastCount = count;
+  lastMin = min;
+  lastMinCell = minCell;
+  lastMax = max;
+  lastMaxCell = maxCell;
+  lastSum = sum;
+  ++scans;
+ }
+
+
+unsigned long LTC6802Stats::getScans() const
+ {
+  return scans;
+ }
+
+
+uint16_t LTC6802Stats::getCount() const
+ {
+  return lastCount;
+ }
+
+
+uint16_t LTC6802Stats::getMin() const
+ {
+  return lastMin;
+ }
+
+
+uint16_t LTC6802Stats::getMinCell() const
+ {
+  return lastMinCell;
+ }
+
+
+uint16_t LTC6802Stats::getMax() const
+ {
+  return lastMax;
+ }
+
+
+uint16_t LTC6802Stats::getMaxCell() const
+ {
+  return lastMaxCell;
+ }
+
+
+uint32_t LTC6802Stats::getSum() const
+ {
+  return lastSum;
+ }
+
+
+uint16_t LTC6802Stats::getAverage() const
+ {
+  return (lastCount == 0) ? 0 : (uint16_t)(lastSum / lastCount);
+ }
+
+
+uint16_t LTC6802Stats::getDelta() const
+ {
+  return (lastCount == 0) ? 0 : (lastMax - lastMin);
+ }
+
+
+uint16_t LTC6802Stats::getEwma(const uint16_t cell) const
+ {
+  return ((ewma == 0) || (cell >= numCells)) ? 0 : ewma[cell];
+ }
@@ -0,0 +1,247 @@
+/**
+ * Copyright 2017, 2019 Dipl.-Inform. Kai Hofmann
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef LTC6802STATS_H_INCLUDED_
+  #define LTC6802STATS_H_INCLUDED_
+
+  #include <LTC6802Platform.h>
+
+  /**
+   * Incremental pack statistics over cell voltages.
+   *
+   * Fed cell by cell while a scan is decoded, so minimum, maximum, sum,
+   * spread and the per cell moving averages are ready when the scan is,
+   * without a second pass over the cells.
+   */
+  class LTC6802Stats
+   {
+    public:
+      /**
+       * Fractional bits of the moving averages.
+       */
+      static const byte ewmaFractionBits = 3;
+
+      /**
+       * Constructor.
+       *
+       * @param ewma Array for numCells moving averages (mV * 8), 0 for none
+       * @param numCells Number of cells in the pack
+       * @param ewmaShift Moving average weight 1 / 2^ewmaShift of a new sample
+       */
+      LTC6802Stats(uint16_t *ewma, uint16_t numCells, byte ewmaShift = 3);
+
+      /**
+       * Start a scan.
+       */
+      void begin();
+
+      /**
+       * Add the next cell voltage of the running scan.
+       *
+       * @param millivolts Cell voltage in mV
+       */
+      void add(const uint16_t millivolts)
+       {
+        if (millivolts < min)
+         {
+          min = millivolts;
+          minCell = count;
+         }
+        if (millivolts > max)
+         {
+          max = millivolts;
+          maxCell = count;
+         }
+        sum += millivolts;
+        if ((ewma != 0) && (count < numCells))
+         {
+          const uint16_t sample = millivolts << ewmaFractionBits;
+          uint16_t &avg = ewma[count];
+          if (scans == 0)
+           {
+            avg = sample;
+           }
+          else if (sample >= avg)
+           {
+            avg += (sample - avg) >> ewmaShift;
+           }
+          else
+           {
+            avg -= (avg - sample) >> ewmaShift;
+           }
+         }
+        ++count;
+       }
+
+      /**
+       * Finish a scan.
+       */
+      void end();
+
+      /**
+       * Get number of finished scans.
+       *
+       * @return Scans
+       */
+      unsigned long getScans() const;
+
+      /**
+       * Get number of cells of the last scan.
+       *
+       * @return Cells
+       */
+      uint16_t getCount() const;
+
+      /**
+       * Get lowest cell voltage of the last scan.
+       *
+       * @return Voltage in mV
+       */
+      uint16_t getMin() const;
+
+      /**
+       * Get index of the lowest cell of the last scan.
+       *
+       * @return Cell index, chip * getCellsPerChip() + cell in a stack
+       */
+      uint16_t getMinCell() const;
+
+      /**
+       * Get highest cell voltage of the last scan.
+       *
+       * @return Voltage in mV
+       */
+      uint16_t getMax() const;
+
+      /**
+       * Get index of the highest cell of the last scan.
+       *
+       * @return Cell index, chip * getCellsPerChip() + cell in a stack
+       */
+      uint16_t getMaxCell() const;
+
+      /**
+       * Get total stack voltage of the last scan.
+       *
+       * @return Voltage in mV
+       */
+      uint32_t getSum() const;
+
+      /**
+       * Get average cell voltage of the last scan.
+       *
+       * @return Voltage in mV
+       */
+      uint16_t getAverage() const;
+
+      /**
+       * Get cell imbalance (highest - lowest) of the last scan.
+       *
+       * @return Voltage in mV
+       */
+      uint16_t getDelta() const;
+
+      /**
+       * Get moving average of a cell.
+       *
+       * @param cell Cell index
+       * @return Voltage in mV * 8
+       */
+      uint16_t getEwma(uint16_t cell) const;
+
+    private:
+      /**
+       * Moving averages, mV * 8.
+       */
+      uint16_t *ewma;
+
+      /**
+       * Number of cells with moving averages.
+       */
+      uint16_t numCells;
+
+      /**
+       * Moving average weight shift.
+       */
+      byte ewmaShift;
+
+      /**
+       * Finished scans.
+       */
+      unsigned long scans = 0;
+
+      /**
+       * Cells added to the running scan.
+       */
+      uint16_t count = 0;
+
+      /**
+       * Running minimum.
+       */
+      uint16_t min = 0xffff;
+
+      /**
+       * Index of running minimum.
+       */
+      uint16_t minCell = 0;
+
+      /**
+       * Running maximum.
+       */
+      uint16_t max = 0;
+
+      /**
+       * Index of running maximum.
+       */
+      uint16_t maxCell = 0;
+
+      /**
+       * Running sum.
+       */
+      uint32_t sum = 0;
+
+      /**
+       * Cells of the last finished scan.
+       */
+      uint16_t lastCount = 0;
+
+      /**
+       * Minimum of the last finished scan.
+       */
+      uint16_t lastMin = 0;
+
+      /**
+       * Index of minimum of the last finished scan.
+       */
+      uint16_t lastMinCell = 0;
+
+      /**
+       * Maximum of the last finished scan.
+       */
+      uint16_t lastMax = 0;
+
+      /**
+       * Index of maximum of the last finished scan.
+       */
+      uint16_t lastMaxCell = 0;
+
+      /**
+       * Sum of the last finished scan.
+       */
+      uint32_t lastSum = 0;
+
+   };
+
+#endif
@@ -0,0 +1,157 @@
+/**
+ * Copyright 2017, 2019 Dipl.-Inform. Kai Hofmann
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <LTC6802Telemetry.h>
+#include <LTC6802Stack.h>
+
+
+/**
+ * Append a 16 bit value little endian.
+ *
+ * @param buf Buffer position
+ * @param value Value
+ * @return Next buffer position
+ */
+static byte *put16(byte *buf, const uint16_t value)
+ {
+  buf[0] = value & 0xff;
+  buf[1] = value >> 8;
+  return buf + 2;
+ }
+
+
+/**
+ * Append bytes.
+ *
+ * @param buf Buffer position
+ * @param data Bytes
+ * @param len Number of bytes
+ * @return Next buffer position
+ */
+static byte *putBytes(byte *buf, const byte *const data, const byte len)
+ {
+  for (byte i = 0; i < len; ++i)
+   {
+    buf[i] = data[i];
+   }
+  return buf + len;
+ }
+
+
+uint16_t LTC6802Telemetry::crc16(uint16_t crc, const byte *const data, const byte len)
+ {
+  for (byte i = 0; i < len; ++i)
+   {
+    crc ^= (uint16_t)data[i] << 8;
+    for (byte bit = 0; bit < 8; ++bit)
+     {
+      crc = (crc & 0x8000) ? ((crc << 1) ^ 0x1021) : (crc << 1);
+     }
+   }
+  return crc;
+ }
+
+
+byte LTC6802Telemetry::encode(const byte chip, const byte groups, const byte *const cfg, const byte *const cv, const byte *const tmp, const byte *const flg)
+ {
+  byte *pos = payload;
+  *pos++ = registerFrame;
+  pos = put16(pos, sequence++);
+  const uint32_t now = micros();
+  pos = put16(pos, (uint16_t)now);
+  pos = put16(pos, (uint16_t)(now >> 16));
+  *pos++ = chip;
+  *pos++ = groups;
+  if (groups & cfgGroup)
+   {
+    pos = putBytes(pos, cfg, LTC6802::cfgRegisters);
+   }
+  if (groups & cellsGroup)
+   {
+    pos = putBytes(pos, cv, LTC6802::cellRegisters);
+   }
+  if (groups & temperaturesGroup)
+   {
+    pos = putBytes(pos, tmp, LTC6802::tmpRegisters);
+   }
+  if (groups & flagsGroup)
+   {
+    pos = putBytes(pos, flg, LTC6802::flgRegisters);
+   }
+  if (groups & millivoltsGroup)
+   {
+    for (byte reg = 0; reg < LTC6802::cellRegisters; reg += 3)
+     {
+      const uint32_t lanes = LTC6802::cellsDecodePair(&cv[reg], true);
+      pos = put16(pos, (uint16_t)lanes);
+      pos = put16(pos, (uint16_t)(lanes >> 16));
+     }
+   }
+  if (groups & decodedTemperaturesGroup)
+   {
+    LTC6802::Temperatures temperatures;
+    LTC6802::temperaturesDecode(tmp, temperatures);
+    pos = put16(pos, temperatures.etmp1);
+    pos = put16(pos, temperatures.etmp2);
+    pos = put16(pos, (uint16_t)temperatures.internal);
+    *pos++ = (temperatures.rev << 1) | (temperatures.thsd ? 1 : 0);
+   }
+  pos = put16(pos, crc16(0xffff, payload, (byte)(pos - payload)));
+  // COBS: every zero is replaced by the distance to the next zero, payloads stay below 254 bytes
+  const byte len = (byte)(pos - payload);
+  byte code = 0;
+  byte *out = frame + 1;
+  for (byte i = 0; i < len; ++i)
+   {
+    if (payload[i] == 0)
+     {
+      frame[code] = (byte)(out - &frame[code]);
+      code = (byte)(out - frame);
+      ++out;
+     }
+    else
+     {
+      *out++ = payload[i];
+     }
+   }
+  frame[code] = (byte)(out - &frame[code]);
+  *out++ = 0;
+  length = (byte)(out - frame);
+  return length;
+ }
+
+
+byte LTC6802Telemetry::encode(LTC6802StackBase &stack, const byte chip, const byte groups)
+ {
+  return encode(chip, groups, stack.cfg(chip), stack.cells(chip), stack.temperatures(chip), stack.flags(chip));
+ }
+
+
+const byte *LTC6802Telemetry::getFrame() const
+ {
+  return frame;
+ }
+
+
+byte LTC6802Telemetry::getLength() const
+ {
+  return length;
+ }
+
+
+uint16_t LTC6802Telemetry::getSequence() const
+ {
+  return sequence;
+ }
@@ -0,0 +1,165 @@
+/**
+ * Copyright 2017, 2019 Dipl.-Inform. Kai Hofmann
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef LTC6802TELEMETRY_H_INCLUDED_
+  #define LTC6802TELEMETRY_H_INCLUDED_
+
+  #include <LTC6802Platform.h>
+
+  class LTC6802StackBase;
+
+  /**
+   * Binary telemetry frames instead of text output.
+   *
+   * Frame payload (little endian):
+   * | type (1) | sequence (2) | timestamp micros (4) | chip (1) | groups (1) | group data | CRC-16 (2)
+   *
+   * Group data follows in bit order of the groups byte. The payload is COBS
+   * encoded and terminated by 0x00, so a receiver resynchronizes at every
+   * zero byte. Frames are built in a buffer inside the encoder and sent
+   * with one write call, e.g. Serial.write(t.getFrame(), t.getLength()).
+   * See extras/telemetry for the host decoder.
+   */
+  class LTC6802Telemetry
+   {
+    public:
+      /**
+       * Frame type of register frames.
+       */
+      static const byte registerFrame = 0x01;
+
+      /**
+       * Group: 6 raw configuration registers.
+       */
+      static const byte cfgGroup = 0x01;
+
+      /**
+       * Group: 18 raw cell voltage registers.
+       */
+      static const byte cellsGroup = 0x02;
+
+      /**
+       * Group: 5 raw temperature registers.
+       */
+      static const byte temperaturesGroup = 0x04;
+
+      /**
+       * Group: 3 raw flag registers.
+       */
+      static const byte flagsGroup = 0x08;
+
+      /**
+       * Group: 12 decoded cell voltages, uint16 mV each.
+       */
+      static const byte millivoltsGroup = 0x10;
+
+      /**
+       * Group: decoded temperatures, ETMP1 code, ETMP2 code (uint16), die temperature 0.1 degree celsius (int16), REV << 1 | THSD (1).
+       */
+      static const byte decodedTemperaturesGroup = 0x20;
+
+      /**
+       * Header bytes: type, sequence, timestamp, chip, groups.
+       */
+      static const byte headerBytes = 9;
+
+      /**
+       * Largest payload including CRC.
+       */
+      static const byte maxPayloadBytes = headerBytes + 6 + 18 + 5 + 3 + 24 + 7 + 2;
+
+      /**
+       * Largest encoded frame: COBS overhead byte and delimiter.
+       */
+      static const byte maxFrameBytes = maxPayloadBytes + 2;
+
+      /**
+       * Continue a CRC-16 (CCITT, x^16 + x^12 + x^5 + 1, initial value 0xffff).
+       *
+       * @param crc CRC of the preceding bytes (0xffff for none)
+       * @param data Bytes
+       * @param len Number of bytes
+       * @return CRC
+       */
+      static uint16_t crc16(uint16_t crc, const byte *data, byte len);
+
+      /**
+       * Encode a frame of register groups.
+       *
+       * @param chip Chip id
+       * @param groups Groups to send
+       * @param cfg 6 configuration registers, for cfgGroup
+       * @param cv 18 cell voltage registers, for cellsGroup and millivoltsGroup
+       * @param tmp 5 temperature registers, for temperaturesGroup and decodedTemperaturesGroup
+       * @param flg 3 flag registers, for flagsGroup
+       * @return Frame length
+       */
+      byte encode(byte chip, byte groups, const byte *cfg, const byte *cv, const byte *tmp, const byte *flg);
+
+      /**
+       * Encode a frame of one chip of a stack.
+       *
+       * @param stack Stack
+       * @param chip Chip index, 0 : bottom chip
+       * @param groups Groups to send
+       * @return Frame length
+       */
+      byte encode(LTC6802StackBase &stack, byte chip, byte groups);
+
+      /**
+       * Get the last encoded frame.
+       *
+       * @return Frame bytes including the 0x00 delimiter
+       */
+      const byte *getFrame() const;
+
+      /**
+       * Get length of the last encoded frame.
+       *
+       * @return Bytes
+       */
+      byte getLength() const;
+
+      /**
+       * Get sequence number of the next frame.
+       *
+       * @return Sequence number
+       */
+      uint16_t getSequence() const;
+
+    private:
+      /**
+       * Sequence number of the next frame.
+       */
+      uint16_t sequence = 0;
+
+      /**
+       * Length of the last frame.
+       */
+      byte length = 0;
+
+      /**
+       * Payload under construction.
+       */
+      byte payload[maxPayloadBytes];
+
+      /**
+       * Encoded frame.
+       */
+      byte frame[maxFrameBytes];
+
+   };
+
+#endif
@@ -0,0 +1,179 @@
+/**
+ * Copyright 2017, 2019 Dipl.-Inform. Kai Hofmann
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef LTC6802THERMISTOR_H_INCLUDED_
+  #define LTC6802THERMISTOR_H_INCLUDED_
+
+  #include <LTC6802Platform.h>
+
+  /**
+   * Compile time math for thermistor tables (C++11 constexpr recursion).
+   */
+  class LTC6802ThermistorMath
+   {
+    public:
+      /**
+       * Natural logarithm of 2.
+       */
+      static constexpr double ln2 = 0.69314718055994531;
+
+      /**
+       * Sum of the series 2 * (z + z^3 / 3 + z^5 / 5 ...) for |z| <= 1/3.
+       *
+       * @param term Current power of z
+       * @param z2 z^2
+       * @param k Current odd exponent
+       * @return Partial sum
+       */
+      static constexpr double series(const double term, const double z2, const int k)
+       {
+        return (k > 31) ? 0.0 : (term / k + series(term * z2, z2, k + 2));
+       }
+
+      /**
+       * Natural logarithm, argument reduced to [1, 2).
+       *
+       * @param x Argument > 0
+       * @return ln(x)
+       */
+      static constexpr double ln(const double x)
+       {
+        return (x >= 2.0) ? (ln2 + ln(x / 2.0)) : ((x < 1.0) ? (ln(x * 2.0) - ln2) : (2.0 * series((x - 1.0) / (x + 1.0), ((x - 1.0) / (x + 1.0)) * ((x - 1.0) / (x + 1.0)), 1)));
+       }
+
+      /**
+       * Temperature of a thermistor from its resistance (beta model).
+       *
+       * @param r Resistance in ohm
+       * @param r25 Resistance at 25 degree celsius in ohm
+       * @param beta Beta value in Kelvin
+       * @return Temperature in degree celsius
+       */
+      static constexpr double celsius(const double r, const double r25, const double beta)
+       {
+        return 1.0 / (1.0 / 298.15 + ln(r / r25) / beta) - 273.15;
+       }
+
+      /**
+       * Table entry: temperature at an A/D code, divider from VREF (3.075V) with pull up, clamped to -55..155 degree celsius.
+       *
+       * @param code A/D code (1.5mV per count)
+       * @param r25 Thermistor resistance at 25 degree celsius in ohm
+       * @param beta Thermistor beta value in Kelvin
+       * @param pullUp Pull up resistance in ohm
+       * @return Temperature in 0.1 degree celsius
+       */
+      static constexpr int16_t entry(const unsigned int code, const double r25, const double beta, const double pullUp)
+       {
+        return (code < 1) ? 1550 : ((code >= 2050) ? -550 : clamp(celsius(pullUp * code / (2050.0 - code), r25, beta) * 10.0));
+       }
+
+      /**
+       * Round and clamp to -550..1550.
+       *
+       * @param deci Temperature in 0.1 degree celsius
+       * @return Rounded temperature
+       */
+      static constexpr int16_t clamp(const double deci)
+       {
+        return (deci > 1550.0) ? 1550 : ((deci < -550.0) ? -550 : (int16_t)((deci < 0.0) ? (deci - 0.5) : (deci + 0.5)));
+       }
+   };
+
+  /**
+   * Compile time index list 0..N-1.
+   */
+  template <unsigned int... Is> struct LTC6802ThermistorIndices {};
+
+  template <unsigned int N, unsigned int... Is> struct LTC6802ThermistorMakeIndices : LTC6802ThermistorMakeIndices<N - 1, N - 1, Is...> {};
+
+  template <unsigned int... Is> struct LTC6802ThermistorMakeIndices<0, Is...>
+   {
+    typedef LTC6802ThermistorIndices<Is...> type;
+   };
+
+  /**
+   * Thermistor lookup table, one entry every Step A/D codes.
+   */
+  template <unsigned long R25, unsigned int Beta, unsigned long PullUp, unsigned int Step, typename Indices> struct LTC6802ThermistorTable;
+
+  template <unsigned long R25, unsigned int Beta, unsigned long PullUp, unsigned int Step, unsigned int... Is> struct LTC6802ThermistorTable<R25, Beta, PullUp, Step, LTC6802ThermistorIndices<Is...> >
+   {
+    static const int16_t values[sizeof...(Is)];
+   };
+
+  template <unsigned long R25, unsigned int Beta, unsigned long PullUp, unsigned int Step, unsigned int... Is> const int16_t LTC6802ThermistorTable<R25, Beta, PullUp, Step, LTC6802ThermistorIndices<Is...> >::values[sizeof...(Is)] PROGMEM = {LTC6802ThermistorMath::entry(Is * Step, R25, Beta, PullUp)...};
+
+  /**
+   * NTC thermistor on an external temperature input.
+   *
+   * The thermistor connects ETMP to V-, the pull up connects ETMP to VREF.
+   * Temperatures come from a table generated at compile time and kept in
+   * flash (PROGMEM) on AVR, linearly interpolated with integer math.
+   *
+   * @tparam R25 Thermistor resistance at 25 degree celsius in ohm
+   * @tparam Beta Thermistor beta value in Kelvin
+   * @tparam PullUp Pull up resistance in ohm
+   */
+  template <unsigned long R25 = 10000, unsigned int Beta = 3380, unsigned long PullUp = 10000> class LTC6802Thermistor
+   {
+    public:
+      /**
+       * A/D codes between two table entries.
+       */
+      static const unsigned int step = 16;
+
+      /**
+       * Table entries, codes 0..2048.
+       */
+      static const unsigned int entries = 2048 / step + 1;
+
+      /**
+       * Convert an external temperature A/D code.
+       *
+       * @param code ETMP A/D code (1.5mV per count)
+       * @return Temperature in 0.1 degree celsius, clamped to -55..155 degree celsius
+       */
+      static int16_t deciCelsius(const word code)
+       {
+        const unsigned int index = code / step;
+        if (index >= entries - 1)
+         {
+          return value(entries - 1);
+         }
+        const int16_t low = value(index);
+        const int16_t high = value(index + 1);
+        return (int16_t)(low + ((int32_t)(high - low) * (int16_t)(code % step)) / (int16_t)step);
+       }
+
+    private:
+      /**
+       * Table of this thermistor.
+       */
+      typedef LTC6802ThermistorTable<R25, Beta, PullUp, step, typename LTC6802ThermistorMakeIndices<entries>::type> Table;
+
+      /**
+       * Read a table entry from flash.
+       *
+       * @param index Entry index
+       * @return Temperature in 0.1 degree celsius
+       */
+      static int16_t value(const unsigned int index)
+       {
+        return (int16_t)pgm_read_word(&Table::values[index]);
+       }
+   };
+
+#endif
@@ -0,0 +1,159 @@
+/**
+ * Copyright 2017, 2019 Dipl.-Inform. Kai Hofmann
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef LTC6802TRANSPORT_H_INCLUDED_
+  #define LTC6802TRANSPORT_H_INCLUDED_
+
+  #include <LTC6802Platform.h>
+
+  /**
+   * SPI transport interface the LTC6802 driver is built on.
+   *
+   * Implementations own the chip select handling and the byte clocking,
+   * so the same driver code runs on the Arduino SPI bus as well as against
+   * the host side chip simulator.
+   */
+  class LTC6802Transport
+   {
+    public:
+      /**
+       * Set SPI clock rate of this bus.
+       *
+       * @param hz Clock rate in Hz
+       */
+      virtual void setClock(unsigned long hz) = 0;
+
+      /**
+       * Get SPI clock rate of this bus.
+       *
+       * @return Clock rate in Hz
+       */
+      virtual unsigned long getClock() const = 0;
+
+      /**
+       * Prepare a chip select pin (output, deselected).
+       *
+       * @param csPin Chip select pin
+       */
+      virtual void attach(byte csPin) = 0;
+
+      /**
+       * Begin a transaction and pull chip select low.
+       *
+       * @param csPin Chip select pin
+       */
+      virtual void select(byte csPin) = 0;
+
+      /**
+       * Release chip select and end the transaction.
+       *
+       * @param csPin Chip select pin
+       */
+      virtual void deselect(byte csPin) = 0;
+
+      /**
+       * End the transaction but keep chip select low, so the chips keep driving SDO (level polling).
+       *
+       * The bus must not be used by anything else until resume().
+       *
+       * @param csPin Chip select pin
+       */
+      virtual void suspend(byte csPin)
+       {
+        (void)csPin;
+       }
+
+      /**
+       * Begin the transaction again on a suspended chip select.
+       *
+       * @param csPin Chip select pin
+       */
+      virtual void resume(byte csPin)
+       {
+        (void)csPin;
+       }
+
+      /**
+       * Clock one byte out and in.
+       *
+       * @param data Byte to send
+       * @return Byte received
+       */
+      virtual byte transfer(byte data) = 0;
+
+      /**
+       * Clock a buffer out and in with one call.
+       *
+       * The received bytes replace the sent ones. The default clocks byte
+       * by byte, transports override it with a bulk (or DMA) transfer.
+       *
+       * @param buf Bytes to send, received bytes on return
+       * @param len Number of bytes
+       */
+      virtual void transfer(byte *buf, size_t len)
+       {
+        for (size_t i = 0; i < len; ++i)
+         {
+          buf[i] = transfer(buf[i]);
+         }
+       }
+
+      /**
+       * Clock command bytes out and discard the bytes received meanwhile.
+       *
+       * The bytes are not needed after the call, so batching transports may
+       * copy them and clock them later.
+       *
+       * @param buf Bytes to send
+       * @param len Number of bytes
+       */
+      virtual void send(const byte *buf, size_t len)
+       {
+        for (size_t i = 0; i < len; ++i)
+         {
+          transfer(buf[i]);
+         }
+       }
+
+      /**
+       * Start collecting frames for one bus call.
+       *
+       * Up to flush() a transport may defer the frames: buffers passed to
+       * transfer() must stay valid and only hold the received bytes after
+       * flush(). Transports that clock immediately ignore it.
+       *
+       * @return true if frames are deferred until flush()
+       */
+      virtual bool batchBegin()
+       {
+        return false;
+       }
+
+      /**
+       * Clock the frames collected since batchBegin().
+       */
+      virtual void flush()
+       {
+       }
+
+    protected:
+      /**
+       * Transports are never deleted through this interface.
+       */
+      ~LTC6802Transport() {}
+
+   };
+
+#endif